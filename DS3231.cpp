@@ -28,6 +28,8 @@ Released into the public domain.
 */
 
 #include "DS3231.h"
+#include "DS3231Driver.h"
+#include "DS3231TimeZone.h"
 
 // These included for the DateTime class inclusion; will try to find a way to
 // not need them in the future...
@@ -45,13 +47,164 @@ Released into the public domain.
 
 #define SECONDS_FROM_1970_TO_2000 946684800
 
+#if defined(DS3231_INSTRUMENTATION)
+static DS3231Stats stats;
+static volatile unsigned long alarmMarkMicros;
+static volatile bool alarmMarked = false;
+
+// Index of the first bucket whose bound (first << i) exceeds value
+static uint8_t statBucket(unsigned long value, unsigned long first) {
+	uint8_t i = 0;
+	while (i < DS3231_HISTOGRAM_BUCKETS - 1 && value >= (first << i)) i++;
+	return i;
+}
+
+static void statCount(uint16_t& counter) {
+	if (counter < 0xFFFF) counter++;
+}
+
+#define STAT_START()				unsigned long statStart = micros()
+#define STAT_READ(count, ok)		do { stats.reads++; stats.bytesRead += (count); \
+	if (!(ok)) statCount(stats.readErrors); \
+	statCount(stats.readLatency[statBucket(micros() - statStart, 64)]); } while (0)
+#define STAT_WRITE(count, ok)		do { stats.writes++; stats.bytesWritten += (count); \
+	if (!(ok)) statCount(stats.writeErrors); \
+	statCount(stats.writeLatency[statBucket(micros() - statStart, 64)]); } while (0)
+#define STAT_ALARM_SERVICED()		do { if (alarmMarked) { alarmMarked = false; \
+	statCount(stats.alarmLatency[statBucket(micros() - alarmMarkMicros, 1024)]); } } while (0)
+#else
+#define STAT_START()
+#define STAT_READ(count, ok)
+#define STAT_WRITE(count, ok)
+#define STAT_ALARM_SERVICED()
+#endif
+
+// BCD encoding table for DS3231BCD::encode(), used when DS3231_BCD_SWAR is 0;
+// the linker drops it otherwise.
+const uint8_t DS3231BCDTable[100] PROGMEM = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99
+};
+
+// Register access shared by DS3231 and RTClib; every bus transaction of
+// the library goes through these two functions.
+static DS3231::BusStatus busRead(TwoWire & bus, byte address, byte reg, byte* buffer, byte count) {
+	STAT_START();
+	DS3231::BusStatus status = DS3231Transfer<TwoWire>::readStatus(bus, address, reg, buffer, count);
+#if defined(WIRE_HAS_TIMEOUT)
+	// requestFrom() reports a timeout only as a short read.
+	if (bus.getWireTimeoutFlag()) {
+		bus.clearWireTimeoutFlag();
+		status = DS3231::BusTimeout;
+	}
+#endif
+	STAT_READ(status == DS3231::BusOk ? count : 0, status == DS3231::BusOk);
+	return status;
+}
+
+static DS3231::BusStatus busWrite(TwoWire & bus, byte address, byte reg, const byte* buffer, byte count) {
+	STAT_START();
+	DS3231::BusStatus status = DS3231Transfer<TwoWire>::writeStatus(bus, address, reg, buffer, count);
+	STAT_WRITE(count, status == DS3231::BusOk);
+	return status;
+}
+
+// Channel selection of TCA9548A-style I2C multiplexers. The last selection
+// is remembered for each bus so that a channel is only written when it
+// changes. A mux whose selection is unknown has channel NO_CHANNEL.
+#define NO_CHANNEL 0xFF
+// No bus recovery pins
+#define NO_PIN 0xFF
+
+struct MuxState {
+	TwoWire * bus;
+	byte mux;		// address of the mux with an open channel, 0 if none
+	byte channel;
+};
+static MuxState muxState[DS3231_MUX_BUSES];
+
+static DS3231::BusStatus selectMux(TwoWire & bus, byte mux, byte channel) {
+	MuxState * state = 0;
+	for (byte i = 0; i < DS3231_MUX_BUSES; i++) {
+		if (muxState[i].bus == &bus) {
+			state = &muxState[i];
+			break;
+		}
+		if (muxState[i].bus == 0) {
+			if (mux == 0) {
+				return DS3231::BusOk;	// no mux was ever used on this bus
+			}
+			state = &muxState[i];
+			state->bus = &bus;
+			state->mux = 0;
+			break;
+		}
+	}
+	if (state == 0) {
+		if (mux == 0) {
+			return DS3231::BusOk;
+		}
+		// More buses with muxes than DS3231_MUX_BUSES; reuse the last slot.
+		state = &muxState[DS3231_MUX_BUSES - 1];
+		state->bus = &bus;
+		state->mux = 0;
+	}
+	if (state->mux == mux && state->channel == channel) {
+		return DS3231::BusOk;
+	}
+
+	DS3231::BusStatus status = DS3231::BusOk;
+	byte mask;
+	// Close the channel of another mux, so that two devices with the
+	// same address never share the bus.
+	if (state->mux != 0 && state->mux != mux) {
+		STAT_START();
+		bus.beginTransmission(state->mux);
+		bus.write((byte)0);
+		status = DS3231Transfer<TwoWire>::wireStatus(bus.endTransmission());
+		STAT_WRITE(1, status == DS3231::BusOk);
+	}
+	if (status == DS3231::BusOk && mux != 0) {
+		STAT_START();
+		mask = 1 << channel;
+		bus.beginTransmission(mux);
+		bus.write(mask);
+		status = DS3231Transfer<TwoWire>::wireStatus(bus.endTransmission());
+		STAT_WRITE(1, status == DS3231::BusOk);
+	}
+	if (status == DS3231::BusOk) {
+		state->mux = mux;
+		state->channel = channel;
+	} else {
+		state->channel = NO_CHANNEL;	// try again next time
+	}
+	return status;
+}
 
 // Constructor
-DS3231::DS3231() : _Wire(Wire) {
+DS3231::DS3231() : _Wire(Wire), _address(CLOCK_ADDRESS), _muxAddress(0), _muxChannel(0),
+	_busTimeout(0), _busBudget(0), _busClock(0), _busRetries(0), _sclPin(NO_PIN), _sdaPin(NO_PIN),
+	_lastError(BusOk), _shadowTime(0), _shadowMaxAge(0), _shadowValid(false) {
 	// nothing to do for this constructor.
 }
 
-DS3231::DS3231(TwoWire & w) : _Wire(w) {
+DS3231::DS3231(TwoWire & w) : _Wire(w), _address(CLOCK_ADDRESS), _muxAddress(0), _muxChannel(0),
+	_busTimeout(0), _busBudget(0), _busClock(0), _busRetries(0), _sclPin(NO_PIN), _sdaPin(NO_PIN),
+	_lastError(BusOk), _shadowTime(0), _shadowMaxAge(0), _shadowValid(false) {
+}
+
+DS3231::DS3231(TwoWire & w, byte address, byte muxAddress, byte muxChannel) : _Wire(w),
+	_address(address), _muxAddress(muxAddress), _muxChannel(muxChannel),
+	_busTimeout(0), _busBudget(0), _busClock(0), _busRetries(0), _sclPin(NO_PIN), _sdaPin(NO_PIN),
+	_lastError(BusOk), _shadowTime(0), _shadowMaxAge(0), _shadowValid(false) {
 }
 
 // Utilities from JeeLabs/Ladyada
@@ -61,20 +214,43 @@ DS3231::DS3231(TwoWire & w) : _Wire(w) {
 
 // DS3231 is smart enough to know this, but keeping it for now so I don't have
 // to rewrite their code. -ADW
-static const uint8_t daysInMonth [] PROGMEM = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+// Days in the year before the first of each month (non-leap year)
+static const uint16_t daysBeforeMonth [] PROGMEM = { 0,31,59,90,120,151,181,212,243,273,304,334 };
 
 // number of days since 2000/01/01, valid for 2001..2099
+// Constant time: one table lookup instead of walking the months. A month
+// out of range is taken as January (0, as the old loop did) or December,
+// so the lookup stays inside the table.
 static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
     if (y >= 2000)
         y -= 2000;
-    uint16_t days = d;
-    for (uint8_t i = 1; i < m; ++i)
-        days += pgm_read_byte(daysInMonth + i - 1);
+    if (m < 1)
+        m = 1;
+    else if (m > 12)
+        m = 12;
+    uint16_t days = d + pgm_read_word(daysBeforeMonth + m - 1);
     if (m > 2 && isleapYear(y))
         ++days;
     return days + 365 * y + (y + 3) / 4 - 1;
 }
 
+// 2000/01/01 + days, as year offset, month and day; valid up to 2136, the
+// whole range of a 32-bit unixtime. Constant time, 16-bit arithmetic only.
+// This is Howard Hinnant's civil_from_days with the year starting on March
+// 1st, so the leap day is the last day of a year. Counting from 1996/03/01
+// every fourth year (yoe % 4 == 3) is a leap year until the year ending
+// on 2100/02/28, which is not (yoe == 103); day 37985 is 2100/03/01.
+static void days2date(uint16_t days, uint8_t& y, uint8_t& m, uint8_t& d) {
+    const uint16_t doe = days + 1401;           // days since 1996/03/01
+    const uint8_t after2100 = doe >= 37985;
+    const uint16_t yoe = (doe - doe / 1460 + after2100) / 365;
+    const uint16_t doy = doe - (365 * yoe + yoe / 4 - after2100);
+    const uint8_t mp = (5 * doy + 2) / 153;     // March == 0
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp + 3 - 12 * (mp >= 10);
+    y = yoe - 4 + (m <= 2);
+}
+
 static long time2long(uint16_t days, uint8_t h, uint8_t m, uint8_t s) {
     return ((days * 24L + h) * 60 + m) * 60 + s;
 }
@@ -94,7 +270,9 @@ static long time2long(uint16_t days, uint8_t h, uint8_t m, uint8_t s) {
 // DateTime implementation - ignores time zones and DST changes
 // NOTE: also ignores leap seconds, see http://en.wikipedia.org/wiki/Leap_second
 
-DateTime::DateTime (uint32_t t) {
+// Unix time as year offset, month, day, hour, minute and second
+static void unix2fields(uint32_t t, uint8_t& y, uint8_t& m, uint8_t& d,
+                        uint8_t& hh, uint8_t& mm, uint8_t& ss) {
   t -= SECONDS_FROM_1970_TO_2000;    // bring to 2000 timestamp from 1970
 
     ss = t % 60;
@@ -102,45 +280,35 @@ DateTime::DateTime (uint32_t t) {
     mm = t % 60;
     t /= 60;
     hh = t % 24;
-    uint16_t days = t / 24;
-    uint8_t leap;
-    for (yOff = 0; ; ++yOff) {
-        leap = isleapYear((uint16_t) yOff);
-        if (days < (uint16_t)(365 + leap))
-            break;
-        days -= (365 + leap);
-    }
-    for (m = 1; ; ++m) {
-        uint8_t daysPerMonth = pgm_read_byte(daysInMonth + m - 1);
-        if (leap && m == 2)
-            ++daysPerMonth;
-        if (days < daysPerMonth)
-            break;
-        days -= daysPerMonth;
-    }
-    d = days + 1;
+    days2date((uint16_t)(t / 24), y, m, d);
+}
+
+DateTime::DateTime (uint32_t t) {
+    unix2fields(t, yOff, m, d, hh, mm, ss);
 }
 
-DateTime::DateTime (uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec) {
-    if (year >= 2000)
-        year -= 2000;
-    yOff = year;
-    m = month;
-    d = day;
-    hh = hour;
-    mm = min;
-    ss = sec;
+// Reads the next unsigned number, skipping any separators before it.
+static const char* parseNumber(const char* p, uint16_t& value) {
+   while (*p && (*p < '0' || *p > '9'))
+      p++;
+   value = 0;
+   while (*p >= '0' && *p <= '9')
+      value = value * 10 + (*p++ - '0');
+   return p;
 }
 
 // supported formats are date "Mmm dd yyyy" and time "hh:mm:ss" (same as __DATE__ and __TIME__)
+// Reentrant, and without sscanf, which costs kilobytes of flash on AVR.
 DateTime::DateTime(const char* date, const char* time) {
-   static const char month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
-   static char buff[4] = {'0','0','0','0'};
-   int y;
-   sscanf(date, "%s %hhu %d", buff, &d, &y);
+   uint16_t d_, y, hh_, mm_, ss_;
+   m = DS3231BuildTime::month(date);
+   parseNumber(parseNumber(date, d_), y);
    yOff = y >= 2000 ? y - 2000 : y;
-   m = (strstr(month_names, buff) - month_names) / 3 + 1;
-   sscanf(time, "%hhu:%hhu:%hhu", &hh, &mm, &ss);
+   d = d_;
+   parseNumber(parseNumber(parseNumber(time, hh_), mm_), ss_);
+   hh = hh_;
+   mm = mm_;
+   ss = ss_;
 }
 
 // get dayofweek info
@@ -159,12 +327,30 @@ uint32_t DateTime::unixtime(void) const {
   return t;
 }
 
-// Slightly modified from JeeLabs / Ladyada
-// Get all date/time at once to avoid rollover (e.g., minute/second don't match)
-static uint8_t bcd2bin (uint8_t val) { return val - 6 * (val >> 4); }
-// Commented to avoid compiler warnings, but keeping in case we want this
-// eventually
-//static uint8_t bin2bcd (uint8_t val) { return val + 6 * (val / 10); }
+long DateTime::secondstime(void) const {
+  uint16_t days = date2days(yOff, m, d);
+  return time2long(days, hh, mm, ss);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// EpochDateTime implementation
+
+EpochDateTime::EpochDateTime (uint16_t year, uint8_t month, uint8_t day,
+                              uint8_t hour, uint8_t min, uint8_t sec)
+    : _t(DateTime(year, month, day, hour, min, sec).unixtime()),
+      yOff(year >= 2000 ? year - 2000 : year), m(month), d(day),
+      hh(hour), mm(min), ss(sec), _fieldsValid(true) {
+}
+
+EpochDateTime::EpochDateTime (const DateTime& dt)
+    : _t(dt.unixtime()), yOff(dt.year() - 2000), m(dt.month()), d(dt.day()),
+      hh(dt.hour()), mm(dt.minute()), ss(dt.second()), _fieldsValid(true) {
+}
+
+void EpochDateTime::decompose() const {
+    unix2fields(_t, yOff, m, d, hh, mm, ss);
+    _fieldsValid = true;
+}
 
 // Sept 2022 changed parameter to uint16_t from uint8_t
 bool isleapYear(const uint16_t y) {
@@ -175,68 +361,57 @@ bool isleapYear(const uint16_t y) {
 }
 
 DateTime RTClib::now(TwoWire & _Wire) {
-  _Wire.beginTransmission(CLOCK_ADDRESS);
-  _Wire.write(0);	// This is the first register address (Seconds)
-  			// We'll read from here on for 7 bytes: secs reg, minutes reg, hours, days, months and years.
-  _Wire.endTransmission();
-
-  _Wire.requestFrom(CLOCK_ADDRESS, 7);
-  uint16_t ss = bcd2bin(_Wire.read() & 0x7F);
-  uint16_t mm = bcd2bin(_Wire.read());
-  uint16_t hh = bcd2bin(_Wire.read());
-  _Wire.read();
-  uint16_t d = bcd2bin(_Wire.read());
-  uint16_t m = bcd2bin(_Wire.read());
-  uint16_t y = bcd2bin(_Wire.read()) + 2000;
+  byte buffer[7];
+  // Start at the first register address (Seconds) and read 7 bytes:
+  // secs reg, minutes reg, hours, days, months and years.
+  selectMux(_Wire, 0, 0);
+  busRead(_Wire, CLOCK_ADDRESS, 0x00, buffer, 7);
+  return DS3231Registers::decodeTime(buffer);
+}
 
-  return DateTime (y, m, d, hh, mm, ss);
+bool DS3231::now(DateTime& dt) {
+	// Same as RTClib::now(), for this DS3231's bus, address and mux channel.
+	byte buffer[7];
+	if (!readRegisters(0x00, buffer, 7)) {
+		return false;
+	}
+	dt = DS3231Registers::decodeTime(buffer);
+	return true;
 }
 
 // simple func to adjust the time of DS3231
 void DS3231::adjust(const DateTime& dt)
 {
-  _Wire.beginTransmission(CLOCK_ADDRESS);
-  _Wire.write(0);
-  _Wire.write(decToBcd(dt.second()));
-  _Wire.write(decToBcd(dt.minute()));
-  _Wire.write(decToBcd(dt.hour()));
-  _Wire.write(decToBcd(dowToDS3231(dt.dayOfTheWeek())));
-  _Wire.write(decToBcd(dt.day()));
-  _Wire.write(decToBcd(dt.month()));
-  _Wire.write(decToBcd(dt.year() - 2000));
-  _Wire.write(0);
-  _Wire.endTransmission();
+  byte buffer[7];
+  DS3231Registers::encodeTime(dt, buffer);
+  writeRegisters(0x00, buffer, 7);
+}
+
+void DS3231::adjust(const EpochDateTime& dt)
+{
+  byte buffer[7];
+  DS3231Registers::encodeTime(dt, buffer);
+  writeRegisters(0x00, buffer, 7);
 }
 
 ///// ERIC'S ORIGINAL CODE FOLLOWS /////
 
 byte DS3231::getSecond() {
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x00);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	return bcdToDec(_Wire.read());
+	byte temp_buffer;
+	readCached(0x00, &temp_buffer, 1);
+	return bcdToDec(temp_buffer);
 }
 
 byte DS3231::getMinute() {
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x01);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	return bcdToDec(_Wire.read());
+	byte temp_buffer;
+	readCached(0x01, &temp_buffer, 1);
+	return bcdToDec(temp_buffer);
 }
 
 byte DS3231::getHour(bool& h12, bool& PM_time) {
 	byte temp_buffer;
 	byte hour;
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x02);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	temp_buffer = _Wire.read();
+	readCached(0x02, &temp_buffer, 1);
 	h12 = temp_buffer & 0b01000000;
 	if (h12) {
 		PM_time = temp_buffer & 0b00100000;
@@ -248,86 +423,124 @@ byte DS3231::getHour(bool& h12, bool& PM_time) {
 }
 
 byte DS3231::getDoW() {
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x03);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	return bcdToDec(_Wire.read());
+	byte temp_buffer;
+	readCached(0x03, &temp_buffer, 1);
+	return bcdToDec(temp_buffer);
 }
 
 byte DS3231::getDate() {
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x04);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	return bcdToDec(_Wire.read());
+	byte temp_buffer;
+	readCached(0x04, &temp_buffer, 1);
+	return bcdToDec(temp_buffer);
 }
 
 byte DS3231::getMonth(bool& Century) {
 	byte temp_buffer;
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x05);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	temp_buffer = _Wire.read();
+	readCached(0x05, &temp_buffer, 1);
 	Century = temp_buffer & 0b10000000;
 	return (bcdToDec(temp_buffer & 0b01111111)) ;
 }
 
 byte DS3231::getYear() {
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x06);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	return bcdToDec(_Wire.read());
+	byte temp_buffer;
+	readCached(0x06, &temp_buffer, 1);
+	return bcdToDec(temp_buffer);
 }
 
 // setEpoch function gives the epoch as parameter and feeds the RTC
 // epoch = UnixTime and starts at 01.01.1970 00:00:00
 // HINT: => the AVR time.h Lib is based on the year 2000
 void DS3231::setEpoch(time_t epoch, bool flag_localtime) {
+	if (flag_localtime) {
 #if defined (__AVR__)
-	epoch -= SECONDS_FROM_1970_TO_2000;
+		epoch -= SECONDS_FROM_1970_TO_2000;
 #endif
-	struct tm tmnow;
-	if (flag_localtime) {
+		struct tm tmnow;
 		localtime_r(&epoch, &tmnow);
+		setDateTime(tmnow.tm_year - 100U, tmnow.tm_mon + 1U, tmnow.tm_mday,
+				tmnow.tm_wday + 1U, tmnow.tm_hour, tmnow.tm_min, tmnow.tm_sec);
 	}
 	else {
-		gmtime_r(&epoch, &tmnow);
+		// UTC needs no time zone, so DateTime does the conversion.
+		DateTime dt((uint32_t)epoch);
+		setDateTime(dt.year() - 2000, dt.month(), dt.day(),
+				dt.dayOfTheWeek() + 1U, dt.hour(), dt.minute(), dt.second());
+	}
+}
+
+void DS3231::setEpoch(time_t epoch, DS3231TimeZone& zone) {
+	// The registers then hold local time, and setEpoch() does no zone
+	// conversion of its own.
+	setEpoch((time_t)zone.toLocal((uint32_t)epoch));
+}
+
+bool DS3231::setDateTime(byte Year, byte Month, byte Date, byte DoW, byte Hour, byte Minute, byte Second, byte fields) {
+	// Sets any combination of the time registers with one burst write.
+	// When the seconds are written, 0x07-0x0f come along in the same read
+	// so the OSF can be cleared without a second read of 0x0f.
+	byte block[0x10];
+	byte first = 0;
+	byte last = 6;
+
+	fields &= AllFields;
+	if (!fields) return true;
+
+	// Only the span of selected registers goes back; rewriting an
+	// unselected seconds register would restart the countdown chain.
+	while (!(fields & (1 << first))) first++;
+	while (!(fields & (1 << last))) last--;
+
+	// Unselected registers inside the span are written back as read, so
+	// they must come from the device: a shadow copy of the running time
+	// may be stale.
+	byte span = (byte)((2 << last) - (1 << first));
+	byte count = (fields & SecondField) ? 0x10 : 0x07;
+	if (fields == span ? !readCached(0x00, block, count) : !readRegisters(0x00, block, count)) {
+		return false;
 	}
-	setSecond(tmnow.tm_sec);
-	setMinute(tmnow.tm_min);
-	setHour(tmnow.tm_hour);
-	setDoW(tmnow.tm_wday + 1U);
-	setDate(tmnow.tm_mday);
-	setMonth(tmnow.tm_mon + 1U);
-	setYear(tmnow.tm_year - 100U);
+
+	if (fields & SecondField)	block[0] = decToBcd(Second);
+	if (fields & MinuteField)	block[1] = decToBcd(Minute);
+	if (fields & HourField)		block[2] = encodeHour(Hour, block[2] & 0b01000000);
+	if (fields & DoWField)		block[3] = decToBcd(DoW);
+	if (fields & DateField)		block[4] = decToBcd(Date);
+	if (fields & MonthField)	block[5] = decToBcd(Month);
+	if (fields & YearField)		block[6] = decToBcd(Year);
+
+	if (!writeRegisters(first, block + first, last - first + 1)) {
+		return false;
+	}
+
+	if (fields & SecondField) {
+		// Clear OSF. Writing 1 to A1F and A2F leaves them unchanged, so an
+		// alarm that fires in between is not lost.
+		byte status = block[0x0f];
+		block[0x0f] = (status & 0b00001000) | 0b00000011;
+		if (!writeRegisters(0x0f, block + 0x0f, 1)) {
+			return false;
+		}
+		if (_shadowValid) {
+			_shadow[0x0f] = status & 0b01111111;
+		}
+	}
+	return true;
 }
 
 void DS3231::setSecond(byte Second) {
 	// Sets the seconds
 	// This function also resets the Oscillator Stop Flag, which is set
 	// whenever power is interrupted.
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x00);
-	_Wire.write(decToBcd(Second));
-	_Wire.endTransmission();
+	byte temp_buffer = decToBcd(Second);
+	if (!writeRegisters(0x00, &temp_buffer, 1)) return;
 	// Clear OSF flag
-	byte temp_buffer = readControlByte(1);
+	if (!readControlByte(temp_buffer, 1)) return;
 	writeControlByte((temp_buffer & 0b01111111), 1);
 }
 
 void DS3231::setMinute(byte Minute) {
 	// Sets the minutes
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x01);
-	_Wire.write(decToBcd(Minute));
-	_Wire.endTransmission();
+	byte temp_buffer = decToBcd(Minute);
+	writeRegisters(0x01, &temp_buffer, 1);
 }
 
 // Following setHour revision by David Merrifield 4/14/2020 correcting handling of 12-hour clock
@@ -340,13 +553,17 @@ void DS3231::setHour(byte Hour) {
 	byte temp_hour;
 
 	// Start by figuring out what the 12/24 mode is
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x02);
-	_Wire.endTransmission();
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	h12 = (_Wire.read() & 0b01000000);
+	if (!readCached(0x02, &temp_hour, 1)) return;
+	h12 = (temp_hour & 0b01000000);
 	// if h12 is true, it's 12h mode; false is 24h.
 
+	temp_hour = encodeHour(Hour, h12);
+	writeRegisters(0x02, &temp_hour, 1);
+}
+
+byte DS3231::encodeHour(byte Hour, bool h12) {
+	// Converts a 24h hour to the hour register format.
+	byte temp_hour;
 	if (h12) {
 		// 12 hour
 		bool am_pm = (Hour > 11);
@@ -362,43 +579,31 @@ void DS3231::setHour(byte Hour) {
 		// 24 hour
 		temp_hour = decToBcd(Hour) & 0b10111111;
 	}
-
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x02);
-	_Wire.write(temp_hour);
-	_Wire.endTransmission();
+	return temp_hour;
 }
 
 void DS3231::setDoW(byte DoW) {
 	// Sets the Day of Week
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x03);
-	_Wire.write(decToBcd(DoW));
-	_Wire.endTransmission();
+	byte temp_buffer = decToBcd(DoW);
+	writeRegisters(0x03, &temp_buffer, 1);
 }
 
 void DS3231::setDate(byte Date) {
 	// Sets the Date
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x04);
-	_Wire.write(decToBcd(Date));
-	_Wire.endTransmission();
+	byte temp_buffer = decToBcd(Date);
+	writeRegisters(0x04, &temp_buffer, 1);
 }
 
 void DS3231::setMonth(byte Month) {
 	// Sets the month
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x05);
-	_Wire.write(decToBcd(Month));
-	_Wire.endTransmission();
+	byte temp_buffer = decToBcd(Month);
+	writeRegisters(0x05, &temp_buffer, 1);
 }
 
 void DS3231::setYear(byte Year) {
 	// Sets the year
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x06);
-	_Wire.write(decToBcd(Year));
-	_Wire.endTransmission();
+	byte temp_buffer = decToBcd(Year);
+	writeRegisters(0x06, &temp_buffer, 1);
 }
 
 void DS3231::setClockMode(bool h12) {
@@ -413,12 +618,10 @@ void DS3231::setClockMode(bool h12) {
 
 	byte temp_buffer;
 
-	// Start by reading byte 0x02.
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x02);
-	_Wire.endTransmission();
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	temp_buffer = _Wire.read();
+	// Start by reading byte 0x02. Not from the shadow: the hour in it
+	// may be stale, and it is written back. Nothing is written if the
+	// read fails.
+	if (!readRegisters(0x02, &temp_buffer, 1)) return;
 
 	// Set the flag to the requested value:
 	if (h12) {
@@ -428,84 +631,128 @@ void DS3231::setClockMode(bool h12) {
 	}
 
 	// Write the byte
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x02);
-	_Wire.write(temp_buffer);
-	_Wire.endTransmission();
+	writeRegisters(0x02, &temp_buffer, 1);
 }
 
-float DS3231::getTemperature() {
+bool DS3231::getTemperatureQuarters(int16_t& quarters) {
 	// Checks the internal thermometer on the DS3231 and returns the
-	// temperature as a floating-point value.
+	// temperature in quarter degrees, without any floating-point math.
+	byte temp_buffer[2];
 
-  // Updated / modified a tiny bit from "Coding Badly" and "Tri-Again"
-  // http://forum.arduino.cc/index.php/topic,22301.0.html
+	// temp registers (11h-12h) get updated automatically every 64s
+	if (!readRegisters(0x11, temp_buffer, 2)) {
+		return false;
+	}
+	// 2's complement integer part in 0x11, quarters in bits 7-6 of 0x12.
+	// Arithmetic shift keeps the sign.
+	quarters = (int16_t)((uint16_t)temp_buffer[0] << 8 | (temp_buffer[1] & 0xC0)) >> 6;
+	return true;
+}
 
-  byte tMSB, tLSB;
-  float temp3231;
+bool DS3231::startTemperatureConversion() {
+	// Forces a temperature conversion and TCXO update, unless one is
+	// already under way.
+	byte temp_buffer[2];
+
+	// Control and status in one read
+	if (!readRegisters(0x0e, temp_buffer, 2)) {
+		return false;
+	}
+	// CONV: a forced conversion is running. BSY: an automatic one is.
+	if ((temp_buffer[0] & 0b00100000) || (temp_buffer[1] & 0b00000100)) {
+		return false;
+	}
+	temp_buffer[0] |= 0b00100000;
+	return writeRegisters(0x0e, temp_buffer, 1);
+}
 
-  // temp registers (11h-12h) get updated automatically every 64s
-  _Wire.beginTransmission(CLOCK_ADDRESS);
-  _Wire.write(0x11);
-  _Wire.endTransmission();
-  _Wire.requestFrom(CLOCK_ADDRESS, 2);
+DS3231::ConversionState DS3231::pollTemperatureConversion(int16_t& quarters) {
+	// CONV stays set until the forced conversion has finished and the
+	// temperature registers hold the new value.
+	byte temp_buffer;
 
-  // Should I do more "if available" checks here?
-  if(_Wire.available()) {
-    tMSB = _Wire.read(); //2's complement int portion
-    tLSB = _Wire.read(); //fraction portion
+	if (!readRegisters(0x0e, &temp_buffer, 1)) {
+		return ConversionFailed;
+	}
+	if (temp_buffer & 0b00100000) {
+		return ConversionBusy;
+	}
+	return getTemperatureQuarters(quarters) ? ConversionDone : ConversionFailed;
+}
 
-    int16_t  itemp  = ( tMSB << 8 | (tLSB & 0xC0) );  // Shift upper byte, add lower
-    temp3231 = ( (float)itemp / 256.0 );              // Scale and return
-  }
-  else {
-    temp3231 = -9999; // Impossible temperature; error value
-  }
+#if !defined(DS3231_NO_FLOAT)
+float DS3231::getTemperature() {
+	// Checks the internal thermometer on the DS3231 and returns the
+	// temperature as a floating-point value.
+	int16_t quarters;
 
-  return temp3231;
+	if (getTemperatureQuarters(quarters)) {
+		return quarters * 0.25f;
+	}
+	return -9999; // Impossible temperature; error value
 }
+#endif
 
-void DS3231::getA1Time(byte& A1Day, byte& A1Hour, byte& A1Minute, byte& A1Second, byte& AlarmBits, bool& A1Dy, bool& A1h12, bool& A1PM) {
-	byte temp_buffer;
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x07);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 4);
-
-	temp_buffer	= _Wire.read();	// Get A1M1 and A1 Seconds
-	A1Second	= bcdToDec(temp_buffer & 0b01111111);
-	// put A1M1 bit in position 0 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>7;
-
-	temp_buffer		= _Wire.read();	// Get A1M2 and A1 minutes
-	A1Minute	= bcdToDec(temp_buffer & 0b01111111);
-	// put A1M2 bit in position 1 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>6;
-
-	temp_buffer	= _Wire.read();	// Get A1M3 and A1 Hour
-	// put A1M3 bit in position 2 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>5;
-	// determine A1 12/24 mode
-	A1h12		= temp_buffer & 0b01000000;
-	if (A1h12) {
-		A1PM	= temp_buffer & 0b00100000;			// determine am/pm
-		A1Hour	= bcdToDec(temp_buffer & 0b00011111);	// 12-hour
-	} else {
-		A1Hour	= bcdToDec(temp_buffer & 0b00111111);	// 24-hour
+// An alarm's registers, from the seconds (alarm 1) or minutes (alarm 2)
+// to the day/date, to and from a DS3231AlarmConfig. The mask bits go to
+// and come from the AlarmBits positions of getA1Time() and getA2Time().
+static void decodeAlarm(byte Alarm, const byte* regs, DS3231AlarmConfig& config) {
+	byte shift = 4;		// A2M2 in bit 4
+	config.second = 0;
+	config.alarmBits = 0;
+	if (Alarm == 1) {
+		config.second = DS3231BCD::decode(regs[0] & 0b01111111);
+		config.alarmBits = regs[0] >> 7;
+		shift = 1;		// A1M2 in bit 1
+		regs++;
+	}
+	config.minute = DS3231BCD::decode(regs[0] & 0b01111111);
+	config.h12 = regs[1] & 0b01000000;
+	config.pm = config.h12 && (regs[1] & 0b00100000);
+	config.hour = DS3231BCD::decode(regs[1] & (config.h12 ? 0b00011111 : 0b00111111));
+	config.dayOfWeek = regs[2] & 0b01000000;
+	config.day = DS3231BCD::decode(regs[2] & (config.dayOfWeek ? 0b00001111 : 0b00111111));
+	for (byte i = 0; i < 3; i++) {
+		config.alarmBits |= (regs[i] >> 7) << (shift + i);
 	}
+}
 
-	temp_buffer	= _Wire.read();	// Get A1M4 and A1 Day/Date
-	// put A1M3 bit in position 3 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>4;
-	// determine A1 day or date flag
-	A1Dy		= (temp_buffer & 0b01000000)>>6;
-	if (A1Dy) {
-		// alarm is by day of week, not date.
-		A1Day	= bcdToDec(temp_buffer & 0b00001111);
+static void encodeAlarm(byte Alarm, const DS3231AlarmConfig& config, byte* regs) {
+	byte shift = 4;
+	if (Alarm == 1) {
+		regs[0] = DS3231BCD::encode(config.second) | (config.alarmBits & 0b00000001) << 7;
+		shift = 1;
+		regs++;
+	}
+	regs[0] = DS3231BCD::encode(config.minute);
+	if (config.h12) {
+		// An hour given in 24h is converted, and is then PM.
+		bool pm = config.pm || config.hour > 12;
+		byte hour = config.hour > 12 ? config.hour - 12 : config.hour;
+		regs[1] = DS3231BCD::encode(hour) | 0b01000000 | (pm ? 0b00100000 : 0);
 	} else {
-		// alarm is by date, not day of week.
-		A1Day	= bcdToDec(temp_buffer & 0b00111111);
+		regs[1] = DS3231BCD::encode(config.hour);
+	}
+	regs[2] = DS3231BCD::encode(config.day) | (config.dayOfWeek ? 0b01000000 : 0);
+	for (byte i = 0; i < 3; i++) {
+		regs[i] |= (config.alarmBits >> (shift + i) & 1) << 7;
+	}
+}
+
+void DS3231::getA1Time(byte& A1Day, byte& A1Hour, byte& A1Minute, byte& A1Second, byte& AlarmBits, bool& A1Dy, bool& A1h12, bool& A1PM) {
+	byte alarm_buffer[4];
+	DS3231AlarmConfig config;
+	readCached(0x07, alarm_buffer, 4);
+	decodeAlarm(1, alarm_buffer, config);
+	A1Day		= config.day;
+	A1Hour		= config.hour;
+	A1Minute	= config.minute;
+	A1Second	= config.second;
+	AlarmBits	= AlarmBits | config.alarmBits;
+	A1Dy		= config.dayOfWeek;
+	A1h12		= config.h12;
+	if (A1h12) {
+		A1PM	= config.pm;
 	}
 }
 
@@ -517,40 +764,18 @@ void DS3231::getA1Time(byte& A1Day, byte& A1Hour, byte& A1Minute, byte& A1Second
 }
 
 void DS3231::getA2Time(byte& A2Day, byte& A2Hour, byte& A2Minute, byte& AlarmBits, bool& A2Dy, bool& A2h12, bool& A2PM) {
-	byte temp_buffer;
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x0b);
-	_Wire.endTransmission();
-
-	_Wire.requestFrom(CLOCK_ADDRESS, 3);
-	temp_buffer	= _Wire.read();	// Get A2M2 and A2 Minutes
-	A2Minute	= bcdToDec(temp_buffer & 0b01111111);
-	// put A2M2 bit in position 4 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>3;
-
-	temp_buffer	= _Wire.read();	// Get A2M3 and A2 Hour
-	// put A2M3 bit in position 5 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>2;
-	// determine A2 12/24 mode
-	A2h12		= temp_buffer & 0b01000000;
+	byte alarm_buffer[3];
+	DS3231AlarmConfig config;
+	readCached(0x0b, alarm_buffer, 3);
+	decodeAlarm(2, alarm_buffer, config);
+	A2Day		= config.day;
+	A2Hour		= config.hour;
+	A2Minute	= config.minute;
+	AlarmBits	= AlarmBits | config.alarmBits;
+	A2Dy		= config.dayOfWeek;
+	A2h12		= config.h12;
 	if (A2h12) {
-		A2PM	= temp_buffer & 0b00100000;			// determine am/pm
-		A2Hour	= bcdToDec(temp_buffer & 0b00011111);	// 12-hour
-	} else {
-		A2Hour	= bcdToDec(temp_buffer & 0b00111111);	// 24-hour
-	}
-
-	temp_buffer	= _Wire.read();	// Get A2M4 and A1 Day/Date
-	// put A2M4 bit in position 6 of DS3231_AlarmBits.
-	AlarmBits	= AlarmBits | (temp_buffer & 0b10000000)>>1;
-	// determine A2 day or date flag
-	A2Dy		= (temp_buffer & 0b01000000)>>6;
-	if (A2Dy) {
-		// alarm is by day of week, not date.
-		A2Day	= bcdToDec(temp_buffer & 0b00001111);
-	} else {
-		// alarm is by date, not day of week.
-		A2Day	= bcdToDec(temp_buffer & 0b00111111);
+		A2PM	= config.pm;
 	}
 }
 
@@ -563,89 +788,71 @@ void DS3231::getA2Time(byte& A2Day, byte& A2Hour, byte& A2Minute, byte& AlarmBit
 
 void DS3231::setA1Time(byte A1Day, byte A1Hour, byte A1Minute, byte A1Second, byte AlarmBits, bool A1Dy, bool A1h12, bool A1PM) {
 	//	Sets the alarm-1 date and time on the DS3231, using A1* information
-	byte temp_buffer;
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x07);	// A1 starts at 07h
-	// Send A1 second and A1M1
-	_Wire.write(decToBcd(A1Second) | ((AlarmBits & 0b00000001) << 7));
-	// Send A1 Minute and A1M2
-	_Wire.write(decToBcd(A1Minute) | ((AlarmBits & 0b00000010) << 6));
-	// Figure out A1 hour
-	if (A1h12) {
-		// Start by converting existing time to h12 if it was given in 24h.
-		if (A1Hour > 12) {
-			// well, then, this obviously isn't a h12 time, is it?
-			A1Hour = A1Hour - 12;
-			A1PM = true;
-		}
-		if (A1PM) {
-			// Afternoon
-			// Convert the hour to BCD and add appropriate flags.
-			temp_buffer = decToBcd(A1Hour) | 0b01100000;
-		} else {
-			// Morning
-			// Convert the hour to BCD and add appropriate flags.
-			temp_buffer = decToBcd(A1Hour) | 0b01000000;
-		}
-	} else {
-		// Now for 24h
-		temp_buffer = decToBcd(A1Hour);
-	}
-	temp_buffer = temp_buffer | ((AlarmBits & 0b00000100)<<5);
-	// A1 hour is figured out, send it
-	_Wire.write(temp_buffer);
-	// Figure out A1 day/date and A1M4
-	temp_buffer = ((AlarmBits & 0b00001000)<<4) | decToBcd(A1Day);
-	if (A1Dy) {
-		// Set A1 Day/Date flag (Otherwise it's zero)
-		temp_buffer = temp_buffer | 0b01000000;
-	}
-	_Wire.write(temp_buffer);
-	// All done!
-	_Wire.endTransmission();
+	DS3231AlarmConfig config = { A1Day, A1Hour, A1Minute, A1Second, AlarmBits, A1Dy, A1h12, A1PM, false, false };
+	byte alarm_buffer[4];	// A1 starts at 07h
+	encodeAlarm(1, config, alarm_buffer);
+	writeRegisters(0x07, alarm_buffer, 4);
 }
 
 void DS3231::setA2Time(byte A2Day, byte A2Hour, byte A2Minute, byte AlarmBits, bool A2Dy, bool A2h12, bool A2PM) {
 	//	Sets the alarm-2 date and time on the DS3231, using A2* information
-	byte temp_buffer;
-	_Wire.beginTransmission(CLOCK_ADDRESS);
-	_Wire.write(0x0b);	// A1 starts at 0bh
-	// Send A2 Minute and A2M2
-	_Wire.write(decToBcd(A2Minute) | ((AlarmBits & 0b00010000) << 3));
-	// Figure out A2 hour
-	if (A2h12) {
-		// Start by converting existing time to h12 if it was given in 24h.
-		if (A2Hour > 12) {
-			// well, then, this obviously isn't a h12 time, is it?
-			A2Hour = A2Hour - 12;
-			A2PM = true;
-		}
-		if (A2PM) {
-			// Afternoon
-			// Convert the hour to BCD and add appropriate flags.
-			temp_buffer = decToBcd(A2Hour) | 0b01100000;
-		} else {
-			// Morning
-			// Convert the hour to BCD and add appropriate flags.
-			temp_buffer = decToBcd(A2Hour) | 0b01000000;
-		}
-	} else {
-		// Now for 24h
-		temp_buffer = decToBcd(A2Hour);
-	}
-	// add in A2M3 bit
-	temp_buffer = temp_buffer | ((AlarmBits & 0b00100000)<<2);
-	// A2 hour is figured out, send it
-	_Wire.write(temp_buffer);
-	// Figure out A2 day/date and A2M4
-	temp_buffer = ((AlarmBits & 0b01000000)<<1) | decToBcd(A2Day);
-	if (A2Dy) {
-		// Set A2 Day/Date flag (Otherwise it's zero)
-		temp_buffer = temp_buffer | 0b01000000;
+	DS3231AlarmConfig config = { A2Day, A2Hour, A2Minute, 0, AlarmBits, A2Dy, A2h12, A2PM, false, false };
+	byte alarm_buffer[3];	// A2 starts at 0bh
+	encodeAlarm(2, config, alarm_buffer);
+	writeRegisters(0x0b, alarm_buffer, 3);
+}
+
+bool DS3231::getAlarms(DS3231AlarmConfig& alarm1, DS3231AlarmConfig& alarm2) {
+	// Both alarms, the control and the status register in one burst.
+	// Never from the shadow: the flags in 0x0F change on their own, and a
+	// burst costs no more than reading 0x0F alone.
+	byte regs[9];
+	if (!readRegisters(0x07, regs, 9)) {
+		return false;
+	}
+	decodeAlarm(1, regs, alarm1);
+	decodeAlarm(2, regs + 4, alarm2);
+	alarm1.enabled = regs[7] & 0b00000001;
+	alarm2.enabled = regs[7] & 0b00000010;
+	alarm1.flag = regs[8] & 0b00000001;
+	alarm2.flag = regs[8] & 0b00000010;
+	return true;
+}
+
+bool DS3231::getAlarm(byte Alarm, DS3231AlarmConfig& config) {
+	// From the alarm's first register through 0x0F in one burst, from the
+	// device as in getAlarms().
+	byte first = Alarm == 1 ? 0x07 : 0x0b;
+	byte mask = Alarm == 1 ? 0b00000001 : 0b00000010;
+	byte regs[9];
+	if (!readRegisters(first, regs, 0x10 - first)) {
+		return false;
+	}
+	decodeAlarm(Alarm == 1 ? 1 : 2, regs, config);
+	config.enabled = regs[0x0e - first] & mask;
+	config.flag = regs[0x0f - first] & mask;
+	return true;
+}
+
+bool DS3231::setAlarm(byte Alarm, const DS3231AlarmConfig& config) {
+	// The alarm's registers and 0x0E go in one write. For alarm 1 that
+	// includes alarm 2's registers, which are read first along with 0x0E
+	// and written back unchanged: one read and one write instead of a
+	// write, a read and another write.
+	byte first = Alarm == 1 ? 0x07 : 0x0b;
+	byte length = Alarm == 1 ? 4 : 3;
+	byte count = 0x0e - first + 1;
+	byte regs[8];
+	if (!readCached(first + length, regs + length, count - length)) {
+		return false;
 	}
-	_Wire.write(temp_buffer);
-	// All done!
-	_Wire.endTransmission();
+	encodeAlarm(Alarm == 1 ? 1 : 2, config, regs);
+	// As turnOnAlarm() and turnOffAlarm(); CONV is not written back, so
+	// a conversion is not started again.
+	byte enable = Alarm == 1 ? 0b00000001 : 0b00000010;
+	byte control = regs[count - 1] & 0b11011111;
+	regs[count - 1] = config.enabled ? control | enable | 0b00000100 : control & ~enable;
+	return writeRegisters(first, regs, count);
 }
 
 void DS3231::setAlarm1Simple(byte hour, byte minute) {
@@ -658,7 +865,8 @@ void DS3231::setAlarm2Simple(byte hour, byte minute) {
 
 void DS3231::turnOnAlarm(byte Alarm) {
 	// turns on alarm number "Alarm". Defaults to 2 if Alarm is not 1.
-	byte temp_buffer = readControlByte(0);
+	byte temp_buffer;
+	if (!readControlByte(temp_buffer, 0)) return;
 	// modify control byte
 	if (Alarm == 1) {
 		temp_buffer = temp_buffer | 0b00000101;
@@ -671,7 +879,8 @@ void DS3231::turnOnAlarm(byte Alarm) {
 void DS3231::turnOffAlarm(byte Alarm) {
 	// turns off alarm number "Alarm". Defaults to 2 if Alarm is not 1.
 	// Leaves interrupt pin alone.
-	byte temp_buffer = readControlByte(0);
+	byte temp_buffer;
+	if (!readControlByte(temp_buffer, 0)) return;
 	// modify control byte
 	if (Alarm == 1) {
 		temp_buffer = temp_buffer & 0b11111110;
@@ -684,7 +893,8 @@ void DS3231::turnOffAlarm(byte Alarm) {
 bool DS3231::checkAlarmEnabled(byte Alarm) {
 	// Checks whether the given alarm is enabled.
 	byte result = 0x0;
-	byte temp_buffer = readControlByte(0);
+	byte temp_buffer;
+	readCached(0x0e, &temp_buffer, 1);
 	if (Alarm == 1) {
 		result = temp_buffer & 0b00000001;
 	} else {
@@ -697,44 +907,150 @@ bool DS3231::checkIfAlarm(byte Alarm) {
 	// Checks whether alarm 1 or alarm 2 flag is on, returns T/F accordingly.
 	// Turns flag off, also.
 	// defaults to checking alarm 2, unless Alarm == 1.
-	byte result;
-	byte temp_buffer = readControlByte(1);
-	if (Alarm == 1) {
-		// Did alarm 1 go off?
-		result = temp_buffer & 0b00000001;
-		// clear flag
-		temp_buffer = temp_buffer & 0b11111110;
-	} else {
-		// Did alarm 2 go off?
-		result = temp_buffer & 0b00000010;
-		// clear flag
-		temp_buffer = temp_buffer & 0b11111101;
-	}
-	writeControlByte(temp_buffer, 1);
-	return result;
+	return checkIfAlarm(Alarm, true);
 }
 
 bool DS3231::checkIfAlarm(byte Alarm, bool clearflag) {
 	// Checks whether alarm 1 or alarm 2 flag is on, returns T/F accordingly.
 	// Clears flag, if clearflag is set
 	// defaults to checking alarm 2, unless Alarm == 1.
-	byte result;
-	byte temp_buffer = readControlByte(1);
+	byte flag = (Alarm == 1) ? 0b00000001 : 0b00000010;
+	byte temp_buffer;
+	if (!readControlByte(temp_buffer, 1)) return false;
+	STAT_ALARM_SERVICED();
+	bool result = temp_buffer & flag;
+	// A flag that is clear needs no write.
+	if (clearflag && result) {
+		clearAlarmFlags(temp_buffer, flag);
+	}
+	return result;
+}
+
+byte DS3231::checkAlarms(bool enabledOnly, bool clearflags) {
+	byte regs[2] = { 0b00000011, 0 };	// 0x0E, 0x0F
+	if (enabledOnly ? !readRegisters(0x0e, regs, 2) : !readRegisters(0x0f, regs + 1, 1)) {
+		return 0;
+	}
+	STAT_ALARM_SERVICED();
+	byte fired = regs[0] & regs[1] & 0b00000011;
+	if (clearflags && fired) {
+		clearAlarmFlags(regs[1], fired);
+	}
+	return fired;
+}
+
+void DS3231::clearAlarmFlags(byte status, byte flags) {
+	// Writing 1 to a flag leaves it unchanged, so the other alarm is not
+	// lost if it fires between the read of status and this write.
+	writeControlByte((status | 0b00000011) & ~flags, 1);
+	if (_shadowValid) {
+		_shadow[0x0f] = status & ~flags;
+	}
+}
+
+// Earliest second of the day, at or after start (seconds since midnight),
+// whose hour, minute and second match; -1 in a field matches anything.
+// Returns -1 if there is none left in the day.
+static long firstMatchInDay(long start, int8_t hour, int8_t minute, int8_t second) {
+	byte startHour = start / 3600;
+	byte startMinute = (start / 60) % 60;
+	for (byte h = startHour; h < 24; h++) {
+		if (hour >= 0 && h != hour) continue;
+		for (byte m = (h == startHour) ? startMinute : 0; m < 60; m++) {
+			if (minute >= 0 && m != minute) continue;
+			byte s = (h == startHour && m == startMinute) ? start % 60 : 0;
+			for (; s < 60; s++) {
+				if (second >= 0 && s != second) continue;
+				return (h * 60L + m) * 60 + s;
+			}
+		}
+	}
+	return -1;
+}
+
+// Next match after from, over every field the alarm compares; a negative
+// field is masked. Each day is tested once, so the search is short:
+// a date that exists at all recurs within 62 days.
+static bool nextAlarmTime(const DateTime& from, byte fromDoW, int8_t day, bool dy,
+		int8_t hour, int8_t minute, int8_t second, DateTime& next) {
+	if (hour > 23 || minute > 59 || second > 59) return false;
+	if (day >= 0 && (dy ? day < 1 || day > 7 : day < 1 || day > 31)) return false;
+
+	uint32_t t = from.unixtime();
+	long start = (from.hour() * 60L + from.minute()) * 60 + from.second() + 1;
+	uint32_t midnight = t - (start - 1);
+	for (uint8_t k = 0; k <= 62; k++, start = 0, midnight += 86400UL) {
+		if (start == 86400L) continue;
+		if (day >= 0) {
+			if (dy) {
+				if ((fromDoW - 1 + k) % 7 + 1 != day) continue;
+			} else if (DateTime(midnight).day() != day) {
+				continue;
+			}
+		}
+		long s = firstMatchInDay(start, hour, minute, second);
+		if (s >= 0) {
+			next = DateTime(midnight + s);
+			return true;
+		}
+	}
+	return false;
+}
+
+// 12-hour alarm fields as a 24-hour hour
+static byte alarmHour24(byte hour, bool h12, bool PM_time) {
+	return h12 ? hour % 12 + (PM_time ? 12 : 0) : hour;
+}
+
+bool DS3231::nextA1Time(const DateTime& from, byte fromDoW, byte A1Day, byte A1Hour, byte A1Minute, byte A1Second, byte AlarmBits, bool A1Dy, bool A1h12, bool A1PM, DateTime& next) {
+	return nextAlarmTime(from, fromDoW,
+		(AlarmBits & 0b00001000) ? -1 : A1Day, A1Dy,
+		(AlarmBits & 0b00000100) ? -1 : alarmHour24(A1Hour, A1h12, A1PM),
+		(AlarmBits & 0b00000010) ? -1 : A1Minute,
+		(AlarmBits & 0b00000001) ? -1 : A1Second, next);
+}
+
+bool DS3231::nextA2Time(const DateTime& from, byte fromDoW, byte A2Day, byte A2Hour, byte A2Minute, byte AlarmBits, bool A2Dy, bool A2h12, bool A2PM, DateTime& next) {
+	// Alarm 2 has no seconds register; it goes off at seconds 00.
+	return nextAlarmTime(from, fromDoW,
+		(AlarmBits & 0b01000000) ? -1 : A2Day, A2Dy,
+		(AlarmBits & 0b00100000) ? -1 : alarmHour24(A2Hour, A2h12, A2PM),
+		(AlarmBits & 0b00010000) ? -1 : A2Minute, 0, next);
+}
+
+byte DS3231::getNextAlarms(byte Alarm, DateTime* next, byte count) {
+	byte time_buffer[7];
+	byte day, hour, minute, second = 0, bits = 0;
+	bool dy, h12, PM_time = false;
+	bool found;
+
+	if (count == 0 || !readRegisters(0x00, time_buffer, 7)) {
+		return 0;
+	}
+	DateTime from = DS3231Registers::decodeTime(time_buffer);
+	byte dow = time_buffer[3];
 	if (Alarm == 1) {
-		// Did alarm 1 go off?
-		result = temp_buffer & 0b00000001;
-		// clear flag
-		temp_buffer = temp_buffer & 0b11111110;
+		getA1Time(day, hour, minute, second, bits, dy, h12, PM_time);
 	} else {
-		// Did alarm 2 go off?
-		result = temp_buffer & 0b00000010;
-		// clear flag
-		temp_buffer = temp_buffer & 0b11111101;
+		getA2Time(day, hour, minute, bits, dy, h12, PM_time);
 	}
-	if (clearflag) {
-		writeControlByte(temp_buffer, 1);
+	if (_lastError != BusOk) {
+		return 0;
 	}
-	return result;
+	for (byte i = 0; i < count; i++) {
+		if (Alarm == 1) {
+			found = nextA1Time(from, dow, day, hour, minute, second, bits, dy, h12, PM_time, next[i]);
+		} else {
+			found = nextA2Time(from, dow, day, hour, minute, bits, dy, h12, PM_time, next[i]);
+		}
+		if (!found) {
+			return 0;
+		}
+		// Step the day of the week along with the date.
+		dow = (dow - 1 + (next[i].unixtime() / 86400UL - from.unixtime() / 86400UL)) % 7 + 1;
+		from = next[i];
+	}
+	return count;
 }
 
 void DS3231::enableOscillator(bool TF, bool battery, byte frequency) {
@@ -748,7 +1064,9 @@ void DS3231::enableOscillator(bool TF, bool battery, byte frequency) {
 	// 3 = 8.192 kHz (Default if frequency byte is out of range)
 	if (frequency > 3) frequency = 3;
 	// read control byte in, but zero out current state of RS2 and RS1.
-	byte temp_buffer = readControlByte(0) & 0b11100111;
+	byte temp_buffer;
+	if (!readControlByte(temp_buffer, 0)) return;
+	temp_buffer = temp_buffer & 0b11100111;
 	if (battery) {
 		// turn on BBSQW flag
 		temp_buffer = temp_buffer | 0b01000000;
@@ -772,7 +1090,8 @@ void DS3231::enableOscillator(bool TF, bool battery, byte frequency) {
 
 void DS3231::enable32kHz(bool TF) {
 	// turn 32kHz pin on or off
-	byte temp_buffer = readControlByte(1);
+	byte temp_buffer;
+	if (!readControlByte(temp_buffer, 1)) return;
 	if (TF) {
 		// turn on 32kHz pin
 		temp_buffer = temp_buffer | 0b00001000;
@@ -786,7 +1105,8 @@ void DS3231::enable32kHz(bool TF) {
 bool DS3231::oscillatorCheck() {
 	// Returns false if the oscillator has been off for some reason.
 	// If this is the case, the time is probably not correct.
-	byte temp_buffer = readControlByte(1);
+	byte temp_buffer;
+	readCached(0x0f, &temp_buffer, 1);
 	bool result = true;
 	if (temp_buffer & 0b10000000) {
 		// Oscillator Stop Flag (OSF) is set, so return false.
@@ -795,45 +1115,278 @@ bool DS3231::oscillatorCheck() {
 	return result;
 }
 
-/*****************************************
-	Private Functions
- *****************************************/
+bool DS3231::getAgingOffset(int8_t& offset) {
+	// The aging offset is a two's complement byte.
+	byte temp_buffer;
+	if (!readCached(0x10, &temp_buffer, 1)) {
+		return false;
+	}
+	offset = (int8_t)temp_buffer;
+	return true;
+}
 
-byte DS3231::decToBcd(byte val) {
-// Convert normal decimal numbers to binary coded decimal
-	return ( (val/10*16) + (val%10) );
+bool DS3231::setAgingOffset(int8_t offset) {
+	byte temp_buffer = (byte)offset;
+	return writeRegisters(0x10, &temp_buffer, 1);
 }
 
-byte DS3231::bcdToDec(byte val) {
-// Convert binary coded decimal to normal decimal numbers
-	return ( (val/16*10) + (val%16) );
+void DS3231::forgetMuxSelection() {
+	// Something else has switched the muxes; re-select before the next access.
+	for (byte i = 0; i < DS3231_MUX_BUSES; i++) {
+		if (muxState[i].bus != 0) {
+			muxState[i].channel = NO_CHANNEL;
+		}
+	}
 }
 
-byte DS3231::readControlByte(bool which) {
+void DS3231::setShadowMaxAge(unsigned long maxAge) {
+	// Enables the register shadow (maxAge > 0) or disables it (0).
+	_shadowMaxAge = maxAge;
+	_shadowValid = false;
+}
+
+bool DS3231::refreshShadow() {
+	// One burst read of every register, 0x00 through 0x12.
+	_shadowValid = readRegisters(0x00, _shadow, sizeof(_shadow));
+	_shadowTime = millis();
+	return _shadowValid;
+}
+
+void DS3231::invalidateShadow() {
+	_shadowValid = false;
+}
+
+// Bits of each register written by applyImage(), by group; 0x11 and 0x12
+// are read-only.
+static const uint8_t imageBits[0x11] PROGMEM = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// time
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// alarms
+	0xDF, 0x08,		// control but CONV, EN32kHz
+	0xFF			// aging offset
+};
+
+static byte imageGroup(byte reg) {
+	return reg < 0x07 ? DS3231::ImageTime : reg < 0x0E ? DS3231::ImageAlarms
+		: reg < 0x10 ? DS3231::ImageControl : DS3231::ImageAging;
+}
+
+bool DS3231::readImage(bits3231& image) {
+	byte buffer[sizeof(bits3231)];
+	if (!readRegisters(0x00, buffer, sizeof(buffer))) {
+		return false;
+	}
+	memcpy(&image, buffer, sizeof(buffer));
+	return true;
+}
+
+bool DS3231::applyImage(const bits3231& image, byte groups) {
+	byte current[sizeof(bits3231)];
+	byte wanted[sizeof(bits3231)];
+	bool differs[0x11];
+	if (!readRegisters(0x00, current, sizeof(current))) {
+		return false;
+	}
+	memcpy(wanted, &image, sizeof(wanted));
+	for (byte reg = 0; reg < 0x11; reg++) {
+		byte mask = (groups & imageGroup(reg)) ? pgm_read_byte(imageBits + reg) : 0;
+		wanted[reg] = (current[reg] & ~mask) | (wanted[reg] & mask);
+		differs[reg] = wanted[reg] != current[reg];
+	}
+	// A time is written whole, so it cannot roll over half-way.
+	for (byte reg = 0; reg < 0x07; reg++) {
+		if (differs[reg]) {
+			memset(differs, true, 0x07);
+			break;
+		}
+	}
+	// Ones leave A2F and A1F as they are, even if one was set since the
+	// read; the device only lets them be cleared. OSF is written back as
+	// read: writing 1 to it is not documented to leave it alone.
+	wanted[0x0F] |= 0b00000011;
+
+	// One write per run of differing registers. A gap of up to two
+	// registers is cheaper to write again (9 bits each) than to close the
+	// transaction and open another (about 20 bits).
+	for (byte reg = 0; reg < 0x11; ) {
+		if (!differs[reg]) {
+			reg++;
+			continue;
+		}
+		byte last = reg;
+		for (byte next = reg + 1; next < 0x11 && next <= last + 3; next++) {
+			if (differs[next]) {
+				last = next;
+			}
+		}
+		if (!writeRegisters(reg, wanted + reg, last - reg + 1)) {
+			return false;
+		}
+		if (reg <= 0x0F && last >= 0x0F) {
+			invalidateShadow();		// it now holds ones for the flags
+		}
+		reg = last + 1;
+	}
+	return true;
+}
+
+#if defined(DS3231_INSTRUMENTATION)
+void DS3231::getStats(DS3231Stats& snapshot) {
+	snapshot = stats;
+}
+
+void DS3231::resetStats() {
+	memset(&stats, 0, sizeof(stats));
+	alarmMarked = false;
+}
+
+void DS3231::markAlarmInterrupt() {
+	// Called from the INT/SQW interrupt; checkIfAlarm() closes the interval.
+	alarmMarkMicros = micros();
+	alarmMarked = true;
+}
+#endif
+
+/*****************************************
+	Private Functions
+ *****************************************/
+
+bool DS3231::readControlByte(byte& control, bool which) {
 	// Read selected control byte
 	// first byte (0) is 0x0e, second (1) is 0x0f
-	_Wire.beginTransmission(CLOCK_ADDRESS);
+	// Always goes to the bus: the flags in 0x0f change on their own.
 	if (which) {
 		// second control byte
-		_Wire.write(0x0f);
+		return readRegisters(0x0f, &control, 1);
 	} else {
 		// first control byte
-		_Wire.write(0x0e);
+		return readRegisters(0x0e, &control, 1);
 	}
-	_Wire.endTransmission();
-	_Wire.requestFrom(CLOCK_ADDRESS, 1);
-	return _Wire.read();
 }
 
 void DS3231::writeControlByte(byte control, bool which) {
 	// Write the selected control byte.
 	// which=false -> 0x0e, true->0x0f.
-	_Wire.beginTransmission(CLOCK_ADDRESS);
 	if (which) {
-		_Wire.write(0x0f);
+		writeRegisters(0x0f, &control, 1);
 	} else {
-		_Wire.write(0x0e);
+		writeRegisters(0x0e, &control, 1);
+	}
+}
+
+bool DS3231::readRegisters(byte reg, byte* buffer, byte count) {
+	// Burst read of count registers, starting at reg.
+	return access(reg, buffer, 0, count);
+}
+
+bool DS3231::access(byte reg, byte* readBuffer, const byte* writeBuffer, byte count) {
+	// One attempt, then up to _busRetries more; none starts after the
+	// budget is spent, so the time spent here is bounded.
+	unsigned long start = micros();
+	for (byte attempt = 0; ; attempt++) {
+		BusStatus status = selectMux(_Wire, _muxAddress, _muxChannel);
+		if (status == BusOk) {
+			status = writeBuffer ? busWrite(_Wire, _address, reg, writeBuffer, count)
+				: busRead(_Wire, _address, reg, readBuffer, count);
+		}
+		_lastError = status;
+		if (status == BusOk) {
+			return true;
+		}
+		if (attempt >= _busRetries) {
+			return false;
+		}
+		// A NACK comes from a missing or busy device, not a stuck bus.
+		if (_sclPin != NO_PIN && status != BusNack) {
+			bool freed = recoverBus(_Wire, _sclPin, _sdaPin);
+			if (_busClock != 0) {
+				_Wire.setClock(_busClock);
+			}
+#if defined(WIRE_HAS_TIMEOUT)
+			if (_busTimeout != 0) {
+				_Wire.setWireTimeout(_busTimeout, true);
+			}
+#endif
+			// A mux may have missed the transfer that selected it.
+			forgetMuxSelection();
+			if (!freed) {
+				_lastError = BusStuck;
+				return false;
+			}
+		}
+		if (_busBudget != 0 && micros() - start >= _busBudget) {
+			return false;
+		}
+	}
+}
+
+void DS3231::setBusTimeout(unsigned long timeout, byte retries, unsigned long budget) {
+	_busTimeout = timeout;
+	_busRetries = retries;
+	_busBudget = budget;
+#if defined(WIRE_HAS_TIMEOUT)
+	if (timeout != 0) {
+		_Wire.setWireTimeout(timeout, true);
+	}
+#endif
+}
+
+void DS3231::setBusRecovery(byte sclPin, byte sdaPin, uint32_t clock) {
+	_sclPin = sclPin;
+	_sdaPin = sdaPin;
+	_busClock = clock;
+}
+
+bool DS3231::recoverBus(TwoWire & w, byte sclPin, byte sdaPin) {
+	// The I2C bus clear procedure: a device stuck in the middle of a read
+	// releases SDA within nine clocks. The lines are driven open-drain,
+	// low as an output, high by letting the pull-ups take them.
+	w.end();
+	pinMode(sdaPin, INPUT);
+	pinMode(sclPin, INPUT);
+	for (byte i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++) {
+		digitalWrite(sclPin, LOW);
+		pinMode(sclPin, OUTPUT);
+		delayMicroseconds(5);
+		pinMode(sclPin, INPUT);
+		delayMicroseconds(5);
+	}
+	bool freed = digitalRead(sdaPin) == HIGH;
+	// STOP: SDA rises while SCL is high.
+	digitalWrite(sdaPin, LOW);
+	pinMode(sdaPin, OUTPUT);
+	delayMicroseconds(5);
+	pinMode(sdaPin, INPUT);
+	delayMicroseconds(5);
+	w.begin();
+	return freed;
+}
+
+bool DS3231::readCached(byte reg, byte* buffer, byte count) {
+	// Serve the read from the shadow if it is enabled and fresh enough,
+	// refreshing it with a single burst read when it is not.
+	if (_shadowMaxAge == 0) {
+		return readRegisters(reg, buffer, count);
+	}
+	if (!_shadowValid || millis() - _shadowTime > _shadowMaxAge) {
+		if (!refreshShadow()) {
+			return readRegisters(reg, buffer, count);
+		}
+	}
+	memcpy(buffer, _shadow + reg, count);
+	return true;
+}
+
+bool DS3231::writeRegisters(byte reg, const byte* buffer, byte count) {
+	// Burst write of count registers, starting at reg.
+	bool ok = access(reg, 0, buffer, count);
+	// Keep the shadow coherent with what was just written. After a
+	// failure the device may hold the old values, the new or a mix.
+	if (!ok) {
+		invalidateShadow();
+	} else if (_shadowValid) {
+		for (byte i = 0; i < count && reg + i < (byte)sizeof(_shadow); i++) {
+			_shadow[reg + i] = buffer[i];
+		}
 	}
-	_Wire.write(control);
-	_Wire.endTransmission();
+	return ok;
 }
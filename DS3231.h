@@ -27,21 +27,28 @@
 #include <Arduino.h>
 #include <time.h>
 #include <Wire.h>
+#include <DS3231BCD.h>
+#include <bytemap.h>
 
 // DateTime (get everything at once) from JeeLabs / Adafruit
 // Simple general-purpose date/time class (no TZ / DST / leap second handling!)
 class DateTime {
 public:
     DateTime (uint32_t t =0);
-    DateTime (uint16_t year, uint8_t month, uint8_t day,
-                uint8_t hour =0, uint8_t min =0, uint8_t sec =0);
+    constexpr DateTime (uint16_t year, uint8_t month, uint8_t day,
+                uint8_t hour =0, uint8_t min =0, uint8_t sec =0)
+        : yOff(year >= 2000 ? year - 2000 : year), m(month), d(day),
+          hh(hour), mm(min), ss(sec) {}
+    // Parses date "Mmm dd yyyy" and time "hh:mm:ss", as in __DATE__ and
+    // __TIME__, at run time. For __DATE__ and __TIME__ themselves, prefer
+    // DS3231_BUILD_TIME, which is parsed by the compiler.
     DateTime (const char* date, const char* time);
-    uint16_t year() const       { return 2000 + yOff; }
-    uint8_t month() const       { return m; }
-    uint8_t day() const         { return d; }
-    uint8_t hour() const        { return hh; }
-    uint8_t minute() const      { return mm; }
-    uint8_t second() const      { return ss; }
+    constexpr uint16_t year() const       { return 2000 + yOff; }
+    constexpr uint8_t month() const       { return m; }
+    constexpr uint8_t day() const         { return d; }
+    constexpr uint8_t hour() const        { return hh; }
+    constexpr uint8_t minute() const      { return mm; }
+    constexpr uint8_t second() const      { return ss; }
     uint8_t dayOfTheWeek() const;
 
     // 32-bit times as seconds since 1/1/2000
@@ -55,9 +62,168 @@ protected:
     uint8_t yOff, m, d, hh, mm, ss;
 };
 
+// A positive or negative length of time, in seconds
+class TimeSpan {
+public:
+    constexpr TimeSpan (int32_t seconds =0) : _seconds(seconds) {}
+    constexpr TimeSpan (int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+        : _seconds(days * 86400L + hours * 3600L + minutes * 60L + seconds) {}
+    constexpr int16_t days() const          { return _seconds / 86400L; }
+    constexpr int8_t hours() const          { return _seconds / 3600 % 24; }
+    constexpr int8_t minutes() const        { return _seconds / 60 % 60; }
+    constexpr int8_t seconds() const        { return _seconds % 60; }
+    constexpr int32_t totalseconds() const  { return _seconds; }
+
+    constexpr TimeSpan operator+ (const TimeSpan& right) const { return TimeSpan(_seconds + right._seconds); }
+    constexpr TimeSpan operator- (const TimeSpan& right) const { return TimeSpan(_seconds - right._seconds); }
+protected:
+    int32_t _seconds;
+};
+
+// Date and time kept as Unix seconds. The calendar fields are worked out
+// the first time one is asked for and kept until the time changes, so
+// unixtime(), dayOfTheWeek(), comparisons and TimeSpan arithmetic never
+// convert between seconds and dates. 2000 through 2099, as DateTime.
+class EpochDateTime {
+public:
+    explicit EpochDateTime (uint32_t t =946684800UL) : _t(t), _fieldsValid(false) {}
+    EpochDateTime (uint16_t year, uint8_t month, uint8_t day,
+                   uint8_t hour =0, uint8_t min =0, uint8_t sec =0);
+    EpochDateTime (const DateTime& dt);
+        // Keeps the fields of dt, so they need not be worked out again.
+
+    uint16_t year() const       { fields(); return 2000 + yOff; }
+    uint8_t month() const       { fields(); return m; }
+    uint8_t day() const         { fields(); return d; }
+    uint8_t hour() const        { fields(); return hh; }
+    uint8_t minute() const      { fields(); return mm; }
+    uint8_t second() const      { fields(); return ss; }
+    uint8_t dayOfTheWeek() const { return (_t / 86400UL + 4) % 7; }
+        // 0 = Sunday, as DateTime
+
+    long secondstime() const    { return _t - 946684800UL; }
+    uint32_t unixtime() const   { return _t; }
+    operator DateTime() const   { fields(); return DateTime(2000 + yOff, m, d, hh, mm, ss); }
+
+    EpochDateTime operator+ (const TimeSpan& span) const { return EpochDateTime(_t + span.totalseconds()); }
+    EpochDateTime operator- (const TimeSpan& span) const { return EpochDateTime(_t - span.totalseconds()); }
+    TimeSpan operator- (const EpochDateTime& right) const { return TimeSpan((int32_t)(_t - right._t)); }
+    EpochDateTime& operator+= (const TimeSpan& span) { _t += span.totalseconds(); _fieldsValid = false; return *this; }
+    EpochDateTime& operator-= (const TimeSpan& span) { _t -= span.totalseconds(); _fieldsValid = false; return *this; }
+
+    bool operator== (const EpochDateTime& right) const { return _t == right._t; }
+    bool operator!= (const EpochDateTime& right) const { return _t != right._t; }
+    bool operator< (const EpochDateTime& right) const  { return _t < right._t; }
+    bool operator<= (const EpochDateTime& right) const { return _t <= right._t; }
+    bool operator> (const EpochDateTime& right) const  { return _t > right._t; }
+    bool operator>= (const EpochDateTime& right) const { return _t >= right._t; }
+protected:
+    void fields() const { if (!_fieldsValid) decompose(); }
+    void decompose() const;
+    uint32_t _t;
+    mutable uint8_t yOff, m, d, hh, mm, ss;
+    mutable bool _fieldsValid;
+};
+
+// Compile-time parsing of __DATE__ ("Mmm dd yyyy", day padded with a
+// space) and __TIME__ ("hh:mm:ss"). Everything here is constexpr, so
+//   constexpr DateTime built = DS3231_BUILD_TIME;
+//   constexpr uint32_t builtUnix = DS3231_BUILD_UNIXTIME;
+// cost no code or run time at all.
+namespace DS3231BuildTime {
+    constexpr uint8_t digit(char c) { return c >= '0' && c <= '9' ? c - '0' : 0; }
+    constexpr uint8_t twoDigits(const char* p) { return digit(p[0]) * 10 + digit(p[1]); }
+
+    // 1-12 from the English month abbreviation, 0 if not recognized
+    constexpr uint8_t month(const char* date) {
+        return date[0] == 'J' ? (date[1] == 'a' ? 1 : date[2] == 'n' ? 6 : 7)
+             : date[0] == 'F' ? 2
+             : date[0] == 'M' ? (date[2] == 'r' ? 3 : 5)
+             : date[0] == 'A' ? (date[1] == 'p' ? 4 : 8)
+             : date[0] == 'S' ? 9
+             : date[0] == 'O' ? 10
+             : date[0] == 'N' ? 11
+             : date[0] == 'D' ? 12 : 0;
+    }
+    constexpr uint8_t day(const char* date) { return twoDigits(date + 4); }
+    constexpr uint16_t year(const char* date) {
+        return twoDigits(date + 7) * 100 + twoDigits(date + 9);
+    }
+    constexpr uint8_t hour(const char* time) { return twoDigits(time); }
+    constexpr uint8_t minute(const char* time) { return twoDigits(time + 3); }
+    constexpr uint8_t second(const char* time) { return twoDigits(time + 6); }
+
+    // Days since 2000/01/01, for 2000-2099
+    constexpr uint16_t days(uint16_t y, uint8_t m, uint8_t d) {
+        return 365U * (y - 2000) + (y - 2000 + 3) / 4 + d - 1
+             + (m > 2 ? (153 * (m - 3) + 2) / 5 + 59 + ((y & 3) == 0) : m == 2 ? 31 : 0);
+    }
+
+    constexpr DateTime dateTime(const char* date, const char* time) {
+        return DateTime(year(date), month(date), day(date),
+                        hour(time), minute(time), second(time));
+    }
+    constexpr uint32_t unixtime(const char* date, const char* time) {
+        return 946684800UL
+             + days(year(date), month(date), day(date)) * 86400UL
+             + hour(time) * 3600UL + minute(time) * 60UL + second(time);
+    }
+}
+
+#define DS3231_BUILD_TIME       DS3231BuildTime::dateTime(__DATE__, __TIME__)
+#define DS3231_BUILD_UNIXTIME   DS3231BuildTime::unixtime(__DATE__, __TIME__)
+
 // Checks if a year is a leap year
 bool isleapYear(const uint16_t);
 
+#if defined(DS3231_INSTRUMENTATION)
+// Bus statistics, collected only when DS3231_INSTRUMENTATION is defined
+// for the whole build (e.g. in build_flags or platform.local.txt); a
+// #define in the sketch does not reach the library.
+#define DS3231_HISTOGRAM_BUCKETS 8
+
+struct DS3231Stats {
+	uint32_t reads;			// register read operations
+	uint32_t writes;		// register write operations
+	uint32_t bytesRead;
+	uint32_t bytesWritten;
+	uint16_t readErrors;	// NACK from endTransmission() or short requestFrom()
+	uint16_t writeErrors;	// non-zero endTransmission()
+	uint16_t readLatency[DS3231_HISTOGRAM_BUCKETS];
+		// bucket i counts operations shorter than 64 << i microseconds,
+		// the last bucket everything longer
+	uint16_t writeLatency[DS3231_HISTOGRAM_BUCKETS];
+	uint16_t alarmLatency[DS3231_HISTOGRAM_BUCKETS];
+		// markAlarmInterrupt() to checkIfAlarm(); bucket i counts
+		// intervals shorter than 1024 << i microseconds (about 1 << i ms)
+};
+#endif
+
+// The settings of one alarm, as the arguments of setA1Time() and
+// setA2Time(), with its enable and flag bits. Used by DS3231::getAlarms(),
+// getAlarm() and setAlarm().
+struct DS3231AlarmConfig {
+	byte day;			// date of the month, or day of the week if dayOfWeek
+	byte hour;			// 0-23, or 1-12 if h12
+	byte minute;
+	byte second;		// alarm 1 only; alarm 2 goes off at second 00
+	byte alarmBits;		// A1M1-A1M4 in bits 0-3, A2M2-A2M4 in bits 4-6, as
+						// AlarmBits of getA1Time() (see the table there)
+	bool dayOfWeek;		// DY/DT
+	bool h12;
+	bool pm;
+	bool enabled;		// A1IE or A2IE
+	bool flag;			// A1F or A2F; read only
+};
+
+// Number of I2C buses on which the library tracks the selected mux
+// channel; see DS3231(TwoWire&, byte, byte, byte).
+#ifndef DS3231_MUX_BUSES
+#define DS3231_MUX_BUSES 2
+#endif
+
+class DS3231TimeZone;
+
 class RTClib {
   public:
 		// Get date and time snapshot
@@ -71,9 +237,65 @@ class DS3231 {
 		//Constructor
 		DS3231();
 		DS3231(TwoWire & w);
+		DS3231(TwoWire & w, byte address, byte muxAddress = 0, byte muxChannel = 0);
+			// A DS3231 at the given address, optionally behind channel
+			// muxChannel (0-7) of a TCA9548A-style I2C multiplexer at
+			// muxAddress. Each access selects the channel first, unless it
+			// is already selected, and closes any other mux's channel on
+			// the same bus. muxAddress 0 means no mux.
 
 		TwoWire & _Wire;
 
+		byte getAddress() const { return _address; }
+		byte getMuxAddress() const { return _muxAddress; }
+		byte getMuxChannel() const { return _muxChannel; }
+		static void forgetMuxSelection();
+			// Call if other code switched a mux used by a DS3231, so the
+			// next access selects its channel again.
+
+		bool now(DateTime& dt);
+			// Reads the date and time in one burst, like RTClib::now(),
+			// from this DS3231. Returns false on a bus error.
+
+		// Bus error handling
+
+		enum BusStatus {
+			BusOk,
+			BusNack,		// address or data not acknowledged
+			BusShortRead,	// fewer bytes received than asked for
+			BusTimeout,		// the Wire timeout expired (WIRE_HAS_TIMEOUT)
+			BusError,		// any other endTransmission() error
+			BusStuck		// SDA held low even after bus recovery
+		};
+		BusStatus getLastError() const { return _lastError; }
+			// Outcome of the last register access that went to the bus.
+			// Reads served from the register shadow leave it alone.
+			// Setters that read a register before writing it back
+			// (setSecond(), setHour(), setClockMode(), turnOnAlarm(),
+			// turnOffAlarm(), enableOscillator(), enable32kHz()) write
+			// nothing when the read fails and leave its error here.
+		void setBusTimeout(unsigned long timeout, byte retries = 0, unsigned long budget = 0);
+			// timeout: longest wait for one I2C transaction, in
+			// microseconds, passed to Wire.setWireTimeout() on cores that
+			// have it (WIRE_HAS_TIMEOUT); 0 leaves the Wire setting alone.
+			// retries: attempts after a failed first one.
+			// budget: no retry starts once budget microseconds have passed
+			// since the first attempt; 0 for no limit.
+			// A register access then blocks for at most budget plus one
+			// attempt, and an attempt for at most four transactions of
+			// timeout each (two without a mux), plus a bus recovery.
+			// The default is a single attempt and Wire's own timeout.
+		void setBusRecovery(byte sclPin, byte sdaPin, uint32_t clock = 0);
+			// Before each retry, except after a NACK, clocks SCL until a
+			// device holding SDA low lets go, sends a STOP and restarts
+			// Wire, as recoverBus(). clock is set again after the restart
+			// if not 0, since Wire.begin() may reset it. A bus that stays
+			// stuck ends the access with BusStuck.
+		static bool recoverBus(TwoWire & w, byte sclPin, byte sdaPin);
+			// Frees a bus held by a device that lost track of a transfer:
+			// up to nine SCL pulses, then a STOP, then w.begin(). Takes
+			// about 100 us. Returns false if SDA is still low.
+
 		// Time-retrieval functions
 
 		// the get*() functions retrieve current values of the registers.
@@ -93,12 +315,39 @@ class DS3231 {
 		// Note that none of these check for sensibility: You can set the
 		// date to July 42nd and strange things will probably result.
 
+		// Field selectors for setDateTime()
+		enum {
+			SecondField	= 0x01,
+			MinuteField	= 0x02,
+			HourField	= 0x04,
+			DoWField	= 0x08,
+			DateField	= 0x10,
+			MonthField	= 0x20,
+			YearField	= 0x40,
+			AllFields	= 0x7F
+		};
+
+		bool setDateTime(byte Year, byte Month, byte Date, byte DoW, byte Hour, byte Minute, byte Second, byte fields = AllFields);
+			// Sets the time registers selected by fields (registers
+			// 0x00-0x06) in one burst write, keeping the 12/24h mode.
+			// The current contents are read once, merged in memory, and
+			// only the span from the first to the last selected register
+			// is written. Setting the seconds also clears the OSF, as
+			// setSecond() does. Returns false on a bus error, in the time
+			// write or in the write clearing the OSF.
+
 		// set epoch function gives the epoch as parameter and feeds the RTC
 		// epoch = UnixTime and starts at 01.01.1970 00:00:00
 		void setEpoch(time_t epoch = 0, bool flag_localtime = false);
+		void setEpoch(time_t epoch, DS3231TimeZone& zone);
+			// Sets the clock to the local time of zone at the UTC epoch,
+			// from the zone's own table instead of localtime_r().
 
 		void adjust(const DateTime& dt);
-			// adjust the time by dt info...
+			// adjust the time by dt info, in one burst write of
+			// registers 0x00-0x06. Always leaves the clock in 24h mode.
+		void adjust(const EpochDateTime& dt);
+			// Same, without working out the day of the week from the date.
 		void setSecond(byte Second);
 			// In addition to setting the seconds, this clears the
 			// "Oscillator Stop Flag".
@@ -117,9 +366,31 @@ class DS3231 {
 		void setClockMode(bool h12);
 			// Set 12/24h mode. True is 12-h, false is 24-hour.
 
-		// Temperature function
+		// Temperature functions
 
+		bool getTemperatureQuarters(int16_t& quarters);
+			// Reads registers 0x11-0x12 and stores the temperature in
+			// quarter degrees C (e.g. 101 = 25.25 C). Shift left by 6 for
+			// Q8.8. Returns false, leaving quarters unchanged, on a bus error.
+		bool startTemperatureConversion();
+			// Sets CONV in 0x0E to start a temperature conversion now,
+			// instead of waiting up to 64 s for the next automatic one.
+			// Returns false, without starting one, if a conversion is
+			// already running (CONV or BSY set) or on a bus error.
+		enum ConversionState {
+			ConversionBusy,
+			ConversionDone,
+			ConversionFailed
+		};
+		ConversionState pollTemperatureConversion(int16_t& quarters);
+			// Does not wait. Returns ConversionBusy while CONV is still set;
+			// otherwise reads the fresh temperature into quarters and
+			// returns ConversionDone, or ConversionFailed on a bus error.
+#if !defined(DS3231_NO_FLOAT)
 		float getTemperature();
+			// Degrees C, or -9999 on a bus error. Define DS3231_NO_FLOAT
+			// to leave out this and every other float function.
+#endif
 
 		// Alarm functions
 
@@ -160,6 +431,19 @@ class DS3231 {
 			// Set the details for Alarm 1
 		void setA2Time(byte A2Day, byte A2Hour, byte A2Minute, byte AlarmBits, bool A2Dy, bool A2h12, bool A2PM);
 			// Set the details for Alarm 2
+		bool getAlarms(DS3231AlarmConfig& alarm1, DS3231AlarmConfig& alarm2);
+			// Both alarms with their enable and flag bits, from registers
+			// 0x07-0x0F read in one burst, never from the shadow. Returns
+			// false on a bus error.
+		bool getAlarm(byte Alarm, DS3231AlarmConfig& config);
+			// One alarm (2 if Alarm is not 1), read in one burst from its
+			// first register through 0x0F.
+		bool setAlarm(byte Alarm, const DS3231AlarmConfig& config);
+			// Programs the alarm and, from config.enabled, its interrupt
+			// enable as turnOnAlarm() or turnOffAlarm() would: one write
+			// from its first register through 0x0E, after reading what
+			// lies between (from the shadow if it is on). config.flag is
+			// ignored; checkIfAlarm() clears the flag.
 		void setAlarm1Simple(byte hour, byte minute);
 			// A simple hour/minute alarm.
 		void setAlarm2Simple(byte hour, byte minute);
@@ -179,6 +463,26 @@ class DS3231 {
 		bool checkIfAlarm(byte Alarm, bool clearflag);
 			// Checks whether the indicated alarm (1 or 2, 2 default);
 			// has been activated. IF clearflag is set, clears alarm flag.
+		byte checkAlarms(bool enabledOnly = false, bool clearflags = true);
+			// Flags of both alarms, A1F in bit 0 and A2F in bit 1, from
+			// one read of 0x0F; of 0x0E-0x0F if enabledOnly, to leave out
+			// an alarm whose interrupt is off. The flags returned are
+			// cleared with one write, the others left as they are.
+			// Returns 0 on a bus error.
+
+		static bool nextA1Time(const DateTime& from, byte fromDoW, byte A1Day, byte A1Hour, byte A1Minute, byte A1Second, byte AlarmBits, bool A1Dy, bool A1h12, bool A1PM, DateTime& next);
+			// Computes when alarm 1, set up as for setA1Time(), next goes
+			// off after the time from, whose day-of-week register value is
+			// fromDoW. Covers every combination of the A1M1-A1M4 bits.
+			// Returns false if the alarm can never go off (e.g. date 32).
+			// Assumes the clock and the alarm use the same 12/24h mode.
+		static bool nextA2Time(const DateTime& from, byte fromDoW, byte A2Day, byte A2Hour, byte A2Minute, byte AlarmBits, bool A2Dy, bool A2h12, bool A2PM, DateTime& next);
+			// Same as nextA1Time() for alarm 2.
+		byte getNextAlarms(byte Alarm, DateTime* next, byte count);
+			// Reads the time and the alarm (1 or 2) from the DS3231 and
+			// fills next[] with up to count upcoming alarm times.
+			// Returns how many were filled: count, or 0 on a bus error or
+			// if the alarm can never go off. The DS3231 must be in 24h mode.
 
 		// Oscillator functions
 
@@ -198,23 +502,114 @@ class DS3231 {
 			// If this returns false, then the clock is probably not
 			// giving you the correct time.
 			// The OSF is cleared by function setSecond();.
+		bool getAgingOffset(int8_t& offset);
+			// Reads the aging offset, register 0x10. Returns false on a
+			// bus error.
+		bool setAgingOffset(int8_t offset);
+			// Writes the aging offset. Each step is about 0.1 ppm at 25 C;
+			// positive values slow the clock, negative values speed it up.
+			// Takes effect at the next temperature conversion.
+
+		// Register shadow functions
+
+		void setShadowMaxAge(unsigned long maxAge);
+			// Serves the get*() functions, getA1Time(), getA2Time(),
+			// checkAlarmEnabled() and oscillatorCheck() from a copy of
+			// registers 0x00-0x12 taken in a single burst read. The copy is
+			// re-read once it is older than maxAge milliseconds.
+			// 0 (the default) disables the shadow.
+		bool refreshShadow();
+			// Re-reads registers 0x00-0x12 into the shadow in one burst.
+			// Returns false if the DS3231 did not supply all 19 bytes.
+		void invalidateShadow();
+			// Discards the shadow; the next cached read refreshes it.
+
+		// Register image functions
+
+		// Register groups for applyImage()
+		enum {
+			ImageTime		= 0x01,		// 0x00-0x06, always written together
+			ImageAlarms		= 0x02,		// 0x07-0x0D
+			ImageControl	= 0x04,		// 0x0E except CONV, EN32kHz in 0x0F
+			ImageAging		= 0x08,		// 0x10
+			ImageConfig		= 0x0E		// everything but the time
+		};
+
+		bool readImage(bits3231& image);
+			// Reads registers 0x00-0x12 in one burst. Returns false on a
+			// bus error. The image can be kept, e.g. in EEPROM, and
+			// restored with applyImage().
+		bool applyImage(const bits3231& image, byte groups = ImageConfig);
+			// Makes the registers of groups match image. Reads the device
+			// once and writes only the registers that differ, neighbours
+			// in one transaction, so a device already set up costs the
+			// read alone. The flags (OSF, A1F, A2F), BSY, CONV and the
+			// temperature are never changed. Returns false on a bus error.
+
+#if defined(DS3231_INSTRUMENTATION)
+		// Instrumentation functions, shared by all DS3231 objects
+
+		static void getStats(DS3231Stats& snapshot);
+			// Copies the counters and histograms.
+		static void resetStats();
+			// Zeroes the counters and histograms.
+		static void markAlarmInterrupt();
+			// Call from the INT/SQW interrupt handler. The next
+			// checkIfAlarm() records the time since into alarmLatency.
+#endif
 
 	private:
 
-		static uint8_t dowToDS3231(uint8_t d) { return d == 0 ? 7 : d; }
-			// Convert dayofweek info to DS3231 format
-		byte decToBcd(byte val);
+		byte encodeHour(byte Hour, bool h12);
+			// Convert a 24h hour to the hour register format for the
+			// given 12/24h mode
+		static byte decToBcd(byte val) { return DS3231BCD::encode(val); }
 			// Convert normal decimal numbers to binary coded decimal
-		byte bcdToDec(byte val);
+		static byte bcdToDec(byte val) { return DS3231BCD::decode(val); }
 			// Convert binary coded decimal to normal decimal numbers
+		bool access(byte reg, byte* readBuffer, const byte* writeBuffer, byte count);
+			// The retry loop of readRegisters() and writeRegisters(); a
+			// write if writeBuffer is not null
+
+		byte _address;
+		byte _muxAddress;
+		byte _muxChannel;
+
+		unsigned long _busTimeout;
+		unsigned long _busBudget;
+		uint32_t _busClock;
+		byte _busRetries;
+		byte _sclPin;
+		byte _sdaPin;
+		BusStatus _lastError;
+
+		byte _shadow[0x13];
+		unsigned long _shadowTime;
+		unsigned long _shadowMaxAge;
+		bool _shadowValid;
 
 	protected:
 
-		byte readControlByte(bool which);
+		bool readRegisters(byte reg, byte* buffer, byte count);
+			// Reads count consecutive registers starting at reg in one
+			// transaction, retried as set by setBusTimeout(). Returns
+			// false on a bus error; getLastError() tells which.
+		bool readCached(byte reg, byte* buffer, byte count);
+			// Same as readRegisters(), but served from the shadow when
+			// it is enabled.
+		bool writeRegisters(byte reg, const byte* buffer, byte count);
+			// Writes count consecutive registers starting at reg in one
+			// transaction, retried as set by setBusTimeout(), and keeps
+			// the shadow in step. Returns false on a bus error.
+
+		bool readControlByte(byte& control, bool which);
 			// Read selected control byte: (0); reads 0x0e, (1) reads 0x0f
+			// Returns false on a bus error, control then being undefined.
 		void writeControlByte(byte control, bool which);
 			// Write the selected control byte.
 			// which == false -> 0x0e, true->0x0f.
+		void clearAlarmFlags(byte status, byte flags);
+			// Clears the A1F/A2F bits in flags, given 0x0F as read.
 
 };
 
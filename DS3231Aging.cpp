@@ -0,0 +1,100 @@
+/*
+DS3231Aging.cpp: aging offset calibration against a reference clock.
+
+The RTC error (RTC time minus reference time, in milliseconds) is fitted
+against the reference time (seconds) by least squares. The means and
+sums of squares are updated one observation at a time, as in Welford's
+algorithm, so no observation needs to be stored and the sums stay
+precise in single-precision floats.
+
+Released into the public domain.
+*/
+
+#include "DS3231Aging.h"
+
+#if !defined(DS3231_NO_FLOAT)
+
+#include <math.h>
+
+// Aging offset steps per ppm of rate error, at 25 C
+#define STEPS_PER_PPM 10
+
+DS3231AgingCalibrator::DS3231AgingCalibrator(DS3231 & rtc) : _rtc(rtc) {
+	reset();
+}
+
+void DS3231AgingCalibrator::reset() {
+	_count = 0;
+	_firstReference = 0;
+	_firstError = 0;
+	_meanX = _meanY = 0;
+	_sxx = _sxy = _syy = 0;
+}
+
+void DS3231AgingCalibrator::addObservation(uint32_t reference, uint32_t rtc,
+		uint16_t referenceMillis, uint16_t rtcMillis) {
+	// RTC error in milliseconds; +-24 days fits in 32 bits.
+	int32_t error = (int32_t)(rtc - reference) * 1000L
+			+ ((int32_t)rtcMillis - (int32_t)referenceMillis);
+	if (_count == 0) {
+		_firstReference = reference;
+		_firstError = error;
+	}
+	float x = (float)(int32_t)(reference - _firstReference)
+			+ referenceMillis * 0.001f;
+	float y = (float)(error - _firstError);
+
+	_count++;
+	float dx = x - _meanX;
+	float dy = y - _meanY;
+	_meanX += dx / _count;
+	_meanY += dy / _count;
+	_sxx += dx * (x - _meanX);
+	_sxy += dx * (y - _meanY);
+	_syy += dy * (y - _meanY);
+}
+
+float DS3231AgingCalibrator::getDrift() const {
+	// The slope is in milliseconds per second; 1 ms/s = 1000 ppm.
+	if (_count < 2 || _sxx <= 0) return 0;
+	return _sxy / _sxx * 1000;
+}
+
+float DS3231AgingCalibrator::getDriftError() const {
+	if (_count < 3 || _sxx <= 0) return -1;
+	// Residual variance about the fitted line
+	float residual = _syy - _sxy * _sxy / _sxx;
+	if (residual < 0) residual = 0;
+	return sqrt(residual / (_count - 2) / _sxx) * 1000;
+}
+
+bool DS3231AgingCalibrator::isConverged(float maxError) const {
+	float error = getDriftError();
+	return error >= 0 && error < maxError;
+}
+
+int DS3231AgingCalibrator::getOffsetChange() const {
+	// A fast clock needs a larger offset to slow it down.
+	float steps = getDrift() * STEPS_PER_PPM;
+	return (int)(steps < 0 ? steps - 0.5f : steps + 0.5f);
+}
+
+bool DS3231AgingCalibrator::apply() {
+	int8_t offset;
+	if (_count < 3 || !_rtc.getAgingOffset(offset)) {
+		return false;
+	}
+	int value = offset + getOffsetChange();
+	if (value > 127) value = 127;
+	if (value < -128) value = -128;
+	if (!_rtc.setAgingOffset((int8_t)value)) {
+		return false;
+	}
+	// The offset is applied at the next conversion. If one is already
+	// running, the next automatic conversion applies it instead.
+	_rtc.startTemperatureConversion();
+	reset();
+	return true;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * DS3231Aging.h
+ *
+ * Calibrates the DS3231 aging offset (register 0x10) against a reference
+ * clock, such as GPS, NTP or a host computer.
+ *
+ * Feed the calibrator pairs of readings taken at the same moment: the
+ * reference time and the RTC time. It fits a straight line through the
+ * RTC error over time; the slope is the rate error of the RTC, in ppm.
+ * Once the standard error of that estimate is small enough, apply()
+ * corrects the aging offset by about 10 steps per ppm.
+ *
+ * The longer the observations span, the smaller the error: with readings
+ * to the nearest second, a span of several days is needed to resolve the
+ * 0.1 ppm size of one offset step. Sub-second readings shorten that.
+ *
+ * The calibrator uses floating-point math and is left out when the library
+ * is built with DS3231_NO_FLOAT.
+ */
+
+#ifndef DS3231Aging_h
+#define DS3231Aging_h
+
+#include <DS3231.h>
+
+#if !defined(DS3231_NO_FLOAT)
+
+class DS3231AgingCalibrator {
+	public:
+
+		DS3231AgingCalibrator(DS3231 & rtc);
+
+		void reset();
+			// Discards all observations.
+		void addObservation(uint32_t reference, uint32_t rtc,
+				uint16_t referenceMillis = 0, uint16_t rtcMillis = 0);
+			// One pair of Unix times taken at the same moment, with
+			// optional milliseconds.
+		uint16_t count() const { return _count; }
+
+		float getDrift() const;
+			// Rate error of the RTC in ppm, positive when it runs fast.
+			// 0 until two observations at different times are available.
+		float getDriftError() const;
+			// Standard error of getDrift(), in ppm. Negative until three
+			// observations are available.
+		bool isConverged(float maxError = 0.02) const;
+			// True once getDriftError() is below maxError ppm. The default
+			// leaves the offset within one step of the best value.
+		int getOffsetChange() const;
+			// The change to the aging offset that would cancel the drift.
+
+		bool apply();
+			// Adds getOffsetChange() to the aging offset, limited to
+			// -128..127, and forces a temperature conversion so that the
+			// new value takes effect. The observations no longer describe
+			// the clock after that, so they are discarded. Returns false,
+			// changing nothing, with fewer than three observations or on
+			// a bus error.
+
+	private:
+
+		DS3231 & _rtc;
+
+		uint16_t _count;
+		uint32_t _firstReference;
+		int32_t _firstError;
+			// Times are kept relative to the first observation to keep
+			// the floating-point sums precise.
+
+		// Running means and sums of squared deviations (Welford)
+		float _meanX, _meanY;
+		float _sxx, _sxy, _syy;
+};
+
+#endif
+
+#endif
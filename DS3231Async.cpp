@@ -0,0 +1,147 @@
+/*
+DS3231Async.cpp: non-blocking reads of the DS3231 registers, driven one step
+at a time by poll().
+
+Released into the public domain.
+*/
+
+#include "DS3231Async.h"
+#include "DS3231Driver.h"
+
+/*****************************************
+	DS3231WireBus
+ *****************************************/
+
+DS3231WireBus::DS3231WireBus(TwoWire & w) : _Wire(w), _address(0), _data(0),
+	_buffer(0), _count(0), _reading(false), _pending(false) {
+}
+
+bool DS3231WireBus::startWrite(uint8_t address, const uint8_t* data, uint8_t count) {
+	if (_pending) return false;
+	_address = address;
+	_data = data;
+	_count = count;
+	_reading = false;
+	_pending = true;
+	return true;
+}
+
+bool DS3231WireBus::startRead(uint8_t address, uint8_t* buffer, uint8_t count) {
+	if (_pending) return false;
+	_address = address;
+	_buffer = buffer;
+	_count = count;
+	_reading = true;
+	_pending = true;
+	return true;
+}
+
+DS3231AsyncBus::Status DS3231WireBus::poll() {
+	if (!_pending) return Error;
+	_pending = false;
+	if (_reading) {
+		uint8_t received = _Wire.requestFrom((int)_address, (int)_count);
+		for (uint8_t i = 0; i < _count; i++) {
+			_buffer[i] = _Wire.read();
+		}
+		return received == _count ? Done : Error;
+	}
+	_Wire.beginTransmission(_address);
+	for (uint8_t i = 0; i < _count; i++) {
+		_Wire.write(_data[i]);
+	}
+	return _Wire.endTransmission() == 0 ? Done : Error;
+}
+
+/*****************************************
+	DS3231Async
+ *****************************************/
+
+DS3231Async::DS3231Async(DS3231AsyncBus & bus, uint8_t address) : _bus(bus),
+	_address(address), _reg(0), _count(0), _state(Idle), _callback(0) {
+	memset(_buffer, 0, sizeof(_buffer));
+	memset(_time, 0, sizeof(_time));
+	memset(_temperature, 0, sizeof(_temperature));
+	memset(_controlStatus, 0, sizeof(_controlStatus));
+}
+
+bool DS3231Async::startTimeRead() {
+	return start(0x00, 7);
+}
+
+bool DS3231Async::startTemperatureRead() {
+	return start(0x11, 2);
+}
+
+bool DS3231Async::startStatusRead() {
+	return start(0x0e, 2);
+}
+
+bool DS3231Async::start(uint8_t reg, uint8_t count) {
+	if (busy()) return false;
+	_reg = reg;
+	_count = count;
+	_state = SendPointer;
+	return true;
+}
+
+void DS3231Async::setCallback(void (*callback)(DS3231Async & reader)) {
+	_callback = callback;
+}
+
+DS3231Async::State DS3231Async::poll() {
+	switch (_state) {
+	case SendPointer:
+		if (_bus.startWrite(_address, &_reg, 1)) {
+			_state = AwaitPointer;
+		} else {
+			finish(Failed);
+		}
+		break;
+	case AwaitPointer:
+		switch (_bus.poll()) {
+		case DS3231AsyncBus::Busy:	break;
+		case DS3231AsyncBus::Done:	_state = Receive; break;
+		default:					finish(Failed);
+		}
+		break;
+	case Receive:
+		if (_bus.startRead(_address, _buffer, _count)) {
+			_state = AwaitData;
+		} else {
+			finish(Failed);
+		}
+		break;
+	case AwaitData:
+		switch (_bus.poll()) {
+		case DS3231AsyncBus::Busy:	break;
+		case DS3231AsyncBus::Done:	finish(Complete); break;
+		default:					finish(Failed);
+		}
+		break;
+	default:
+		break;
+	}
+	return _state;
+}
+
+void DS3231Async::finish(State state) {
+	if (state == Complete) {
+		// Read into _buffer, so a read that fails part way never
+		// overwrites a result.
+		uint8_t* result = _reg == 0x00 ? _time : _reg == 0x11 ? _temperature : _controlStatus;
+		memcpy(result, _buffer, _count);
+	}
+	_state = state;
+	if (_callback) {
+		_callback(*this);
+	}
+}
+
+DateTime DS3231Async::getTime() const {
+	return DS3231Registers::decodeTime(_time);
+}
+
+int16_t DS3231Async::getTemperatureQuarters() const {
+	return (int16_t)((uint16_t)_temperature[0] << 8 | (_temperature[1] & 0xC0)) >> 6;
+}
@@ -0,0 +1,119 @@
+/*
+ * DS3231Async.h
+ *
+ * Non-blocking reads of the DS3231 time, temperature and control/status
+ * registers.
+ *
+ * A read is started with one of the start*() functions and then advanced
+ * by calling poll() from loop(); every poll() does at most one step of the
+ * transaction, so the main loop is never held for the whole exchange.
+ * The steps run on a DS3231AsyncBus. DS3231WireBus runs them on an
+ * ordinary TwoWire, one bus phase per poll(); a driver for interrupt- or
+ * DMA-based I2C can implement DS3231AsyncBus to make each phase
+ * non-blocking as well.
+ */
+
+#ifndef DS3231Async_h
+#define DS3231Async_h
+
+#include <DS3231.h>
+
+class DS3231AsyncBus {
+	public:
+		enum Status { Busy, Done, Error };
+
+		virtual ~DS3231AsyncBus() {}
+		virtual bool startWrite(uint8_t address, const uint8_t* data, uint8_t count) = 0;
+			// Begins a write transaction. Returns false if it could not
+			// be started.
+		virtual bool startRead(uint8_t address, uint8_t* buffer, uint8_t count) = 0;
+			// Begins a read transaction into buffer, which stays in use
+			// until poll() reports Done or Error.
+		virtual Status poll() = 0;
+			// Progress of the transaction last started.
+};
+
+// Runs each transaction on a TwoWire during the first poll() after it was
+// started. Blocks for one bus phase at a time, never for a whole read.
+class DS3231WireBus : public DS3231AsyncBus {
+	public:
+		DS3231WireBus(TwoWire & w = Wire);
+		virtual bool startWrite(uint8_t address, const uint8_t* data, uint8_t count);
+		virtual bool startRead(uint8_t address, uint8_t* buffer, uint8_t count);
+		virtual Status poll();
+
+	private:
+		TwoWire & _Wire;
+		uint8_t _address;
+		const uint8_t* _data;
+		uint8_t* _buffer;
+		uint8_t _count;
+		bool _reading;
+		bool _pending;
+};
+
+class DS3231Async {
+	public:
+
+		enum State {
+			Idle,			// nothing started yet
+			SendPointer,	// about to write the register address
+			AwaitPointer,	// register address write in progress
+			Receive,		// about to start the read
+			AwaitData,		// read in progress
+			Complete,		// result ready
+			Failed			// the bus reported an error
+		};
+
+		DS3231Async(DS3231AsyncBus & bus, uint8_t address = 0x68);
+
+		bool startTimeRead();
+			// Registers 0x00-0x06. Result: getTime().
+		bool startTemperatureRead();
+			// Registers 0x11-0x12. Result: getTemperatureQuarters().
+		bool startStatusRead();
+			// Registers 0x0E-0x0F. Result: getControl(), getStatus().
+			// Each start function returns false if a read is still
+			// in progress.
+
+		State poll();
+			// Advances the current read by at most one step and returns
+			// the new state. Calls the callback on Complete or Failed.
+		State state() const { return _state; }
+		bool busy() const { return _state != Idle && _state != Complete && _state != Failed; }
+
+		void setCallback(void (*callback)(DS3231Async & reader));
+			// Called from poll() when a read completes or fails.
+
+		DateTime getTime() const;
+			// From the last completed time read, whatever was read
+			// since. Each kind of read keeps its own result; a failed
+			// read leaves the previous one.
+		int16_t getTemperatureQuarters() const;
+			// From the last completed temperature read, in quarter
+			// degrees C.
+#if !defined(DS3231_NO_FLOAT)
+		float getTemperature() const { return getTemperatureQuarters() * 0.25f; }
+			// The same, in degrees C.
+#endif
+		byte getControl() const { return _controlStatus[0]; }
+		byte getStatus() const { return _controlStatus[1]; }
+			// From the last completed status read.
+
+	private:
+		bool start(uint8_t reg, uint8_t count);
+		void finish(State state);
+
+		DS3231AsyncBus & _bus;
+		uint8_t _address;
+		uint8_t _reg;
+		uint8_t _count;
+		State _state;
+		void (*_callback)(DS3231Async & reader);
+		uint8_t _buffer[7];			// the read in progress
+		uint8_t _time[7];			// completed results, by kind
+		uint8_t _temperature[2];
+		uint8_t _controlStatus[2];
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * DS3231BCD.h
+ *
+ * Binary coded decimal conversion of DS3231 register values, one at a
+ * time or a whole block at once.
+ *
+ * Two implementations, chosen with DS3231_BCD_SWAR:
+ *   1 (default except on AVR): the bytes of a block are packed into a
+ *     64-bit word and converted together with a few word operations
+ *     ("SIMD within a register").
+ *   0 (default on AVR): one byte at a time. Decoding is a shift and a
+ *     multiply; encoding looks the value up in a 100-byte table in flash,
+ *     as the AVR has no divide instruction and 64-bit arithmetic is slow.
+ * Both give the same results as the original divide and modulo formulas
+ * for every byte value.
+ */
+
+#ifndef DS3231BCD_h
+#define DS3231BCD_h
+
+#include <Arduino.h>
+
+#ifndef DS3231_BCD_SWAR
+#if defined(__AVR__)
+#define DS3231_BCD_SWAR 0
+#else
+#define DS3231_BCD_SWAR 1
+#endif
+#endif
+
+// BCD values of 0-99, defined in DS3231.cpp
+extern const uint8_t DS3231BCDTable[100] PROGMEM;
+
+namespace DS3231BCD {
+    // One value. constexpr, for use at compile time; encode() is the
+    // faster run-time choice on AVR.
+    constexpr uint8_t toDec(uint8_t bcd) { return bcd - 6 * (bcd >> 4); }
+    constexpr uint8_t toBcd(uint8_t dec) { return dec + 6 * (dec / 10); }
+
+    inline uint8_t decode(uint8_t bcd) { return toDec(bcd); }
+    inline uint8_t encode(uint8_t dec) {
+#if DS3231_BCD_SWAR
+        return toBcd(dec);
+#else
+        return dec < 100 ? pgm_read_byte(&DS3231BCDTable[dec]) : toBcd(dec);
+#endif
+    }
+
+    // SWAR kernels. decodeLanes() converts all eight bytes of a word;
+    // no byte can carry or borrow into the next. encodeLanes() converts
+    // four 16-bit lanes, each holding 0-99: x / 10 is (x * 103) >> 10,
+    // exact below 179, and x * 103 stays within its lane.
+    constexpr uint64_t Nibbles = 0x0F0F0F0F0F0F0F0FULL;
+    constexpr uint64_t LaneDigits = 0x000F000F000F000FULL;
+
+    constexpr uint64_t decodeLanes(uint64_t bcd) {
+        return bcd - 6 * ((bcd >> 4) & Nibbles);
+    }
+    constexpr uint64_t encodeLanes(uint64_t dec) {
+        return dec + 6 * (((dec * 103) >> 10) & LaneDigits);
+    }
+
+    // count (0-8) bytes as a little-endian word with 8-bit lanes, and
+    // count (0-4) bytes with 16-bit lanes
+    constexpr uint64_t pack8(const uint8_t* p, uint8_t count) {
+        return count == 0 ? 0 : p[0] | pack8(p + 1, count - 1) << 8;
+    }
+    constexpr uint64_t pack16(const uint8_t* p, uint8_t count) {
+        return count == 0 ? 0 : p[0] | pack16(p + 1, count - 1) << 16;
+    }
+
+    // count values from bcd to dec and from dec to bcd; the arrays may be
+    // the same. Encoded values must be 0-99.
+    inline void decodeBlock(const uint8_t* bcd, uint8_t* dec, uint8_t count) {
+#if DS3231_BCD_SWAR
+        while (count) {
+            uint8_t n = count < 8 ? count : 8;
+            uint64_t word = decodeLanes(pack8(bcd, n));
+            for (uint8_t i = 0; i < n; i++) {
+                dec[i] = (uint8_t)(word >> (8 * i));
+            }
+            bcd += n;
+            dec += n;
+            count -= n;
+        }
+#else
+        for (uint8_t i = 0; i < count; i++) {
+            dec[i] = decode(bcd[i]);
+        }
+#endif
+    }
+
+    inline void encodeBlock(const uint8_t* dec, uint8_t* bcd, uint8_t count) {
+#if DS3231_BCD_SWAR
+        while (count) {
+            uint8_t n = count < 4 ? count : 4;
+            uint64_t word = encodeLanes(pack16(dec, n));
+            for (uint8_t i = 0; i < n; i++) {
+                bcd[i] = (uint8_t)(word >> (16 * i));
+            }
+            dec += n;
+            bcd += n;
+            count -= n;
+        }
+#else
+        for (uint8_t i = 0; i < count; i++) {
+            bcd[i] = encode(dec[i]);
+        }
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+DS3231Batch.cpp: array conversion between Unix times and calendar fields,
+written for auto-vectorization.
+
+Released into the public domain.
+*/
+
+#include "DS3231Batch.h"
+
+#if DS3231_BATCH_THREADS
+#include <thread>
+#include <vector>
+#endif
+
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+// Arrays shorter than this per thread are not worth a thread.
+#define MIN_PER_THREAD 16384
+
+DS3231Batch::Fields DS3231Batch::slice(const Fields& fields, size_t offset) {
+	Fields part = { fields.year + offset, fields.month + offset, fields.day + offset,
+		fields.hour + offset, fields.minute + offset, fields.second + offset };
+	return part;
+}
+
+// The loop bodies repeat DateTime's arithmetic in 32-bit lanes: the date
+// as in days2date() (see DS3231.cpp), the days before a month by formula
+// instead of the daysBeforeMonth table, and every condition as a 0 or 1
+// value rather than a branch.
+
+// Each array is a separate restrict parameter: the compiler can then
+// vectorize without run-time checks that the arrays do not overlap.
+static void fieldsKernel(const uint32_t* __restrict__ in, uint16_t* __restrict__ year,
+		uint8_t* __restrict__ month, uint8_t* __restrict__ day, uint8_t* __restrict__ hour,
+		uint8_t* __restrict__ minute, uint8_t* __restrict__ second, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		uint32_t t = in[i] - SECONDS_FROM_1970_TO_2000;
+		uint32_t days = t / 86400;
+		uint32_t s = t - days * 86400;
+		uint32_t h = s / 3600;
+		s -= h * 3600;
+		uint32_t mi = s / 60;
+
+		uint32_t doe = days + 1401;				// days since 1996/03/01
+		uint32_t after2100 = doe >= 37985;
+		uint32_t yoe = (doe - doe / 1460 + after2100) / 365;
+		uint32_t doy = doe - (365 * yoe + yoe / 4 - after2100);
+		uint32_t mp = (5 * doy + 2) / 153;		// March == 0
+		uint32_t m = mp + 3 - 12 * (mp >= 10);
+
+		year[i] = (uint16_t)(1996 + yoe + (m <= 2));
+		month[i] = (uint8_t)m;
+		day[i] = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+		hour[i] = (uint8_t)h;
+		minute[i] = (uint8_t)mi;
+		second[i] = (uint8_t)(s - mi * 60);
+	}
+}
+
+static void unixtimeKernel(const uint16_t* __restrict__ year, const uint8_t* __restrict__ month,
+		const uint8_t* __restrict__ day, const uint8_t* __restrict__ hour,
+		const uint8_t* __restrict__ minute, const uint8_t* __restrict__ second,
+		uint32_t* __restrict__ out, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		// DateTime keeps the year as an 8-bit offset from 2000.
+		uint32_t y = (uint8_t)(year[i] - 2000 * (year[i] >= 2000));
+		uint32_t m = month[i];
+		uint32_t leap = (y % 4 == 0) & ((y % 100 != 0) | (y % 400 == 0));
+		uint32_t before = (m > 2) * ((153 * (m - 3) + 2) / 5 + 59 + leap) + (m == 2) * 31;
+		uint32_t days = day[i] + before + 365 * y + (y + 3) / 4 - 1;
+		out[i] = ((days * 24 + hour[i]) * 60 + minute[i]) * 60 + second[i]
+			+ SECONDS_FROM_1970_TO_2000;
+	}
+}
+
+void DS3231Batch::toFields(const uint32_t* unixtime, const Fields& fields, size_t count) {
+	fieldsKernel(unixtime, fields.year, fields.month, fields.day, fields.hour,
+		fields.minute, fields.second, count);
+}
+
+void DS3231Batch::toUnixtime(const Fields& fields, uint32_t* unixtime, size_t count) {
+	unixtimeKernel(fields.year, fields.month, fields.day, fields.hour,
+		fields.minute, fields.second, unixtime, count);
+}
+
+#if DS3231_BATCH_THREADS
+
+// Runs convert on count / threads elements per thread, the last share
+// on the calling thread.
+template <class Convert>
+static void runParallel(size_t count, unsigned threads, Convert convert) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	if (threads > count / MIN_PER_THREAD) {
+		threads = count / MIN_PER_THREAD;
+	}
+	if (threads <= 1) {
+		convert(0, count);
+		return;
+	}
+	// Shares in multiples of 64, so no two threads write the same cache line.
+	size_t share = (count / threads + 63) & ~(size_t)63;
+	std::vector<std::thread> workers;
+	size_t start = 0;
+	for (unsigned i = 0; i + 1 < threads && start + share < count; i++, start += share) {
+		workers.push_back(std::thread(convert, start, share));
+	}
+	convert(start, count - start);
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+void DS3231Batch::toFieldsParallel(const uint32_t* unixtime, const Fields& fields, size_t count,
+		unsigned threads) {
+	runParallel(count, threads, [=](size_t start, size_t n) {
+		toFields(unixtime + start, slice(fields, start), n);
+	});
+}
+
+void DS3231Batch::toUnixtimeParallel(const Fields& fields, uint32_t* unixtime, size_t count,
+		unsigned threads) {
+	runParallel(count, threads, [=](size_t start, size_t n) {
+		toUnixtime(slice(fields, start), unixtime + start, n);
+	});
+}
+
+#endif
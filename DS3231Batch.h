@@ -0,0 +1,64 @@
+/*
+ * DS3231Batch.h
+ *
+ * Conversion of whole arrays of timestamps, for post-processing logs on a
+ * computer: Unix times to calendar fields and back, with exactly the
+ * results of DateTime(uint32_t) and DateTime::unixtime().
+ *
+ * The fields are kept in one array each (structure of arrays). The loops
+ * have no branches or table lookups, so a compiler can vectorize them;
+ * with GCC or Clang use -O3, or -O2 -ftree-vectorize, and -march=native
+ * or similar for the widest vectors.
+ *
+ * On a host (ARDUINO not defined), toFieldsParallel() and
+ * toUnixtimeParallel() split the arrays over several std::threads. Define
+ * DS3231_BATCH_THREADS as 0 to leave them out, or as 1 to build them for
+ * a board with std::thread. Older toolchains need -pthread to link them.
+ */
+
+#ifndef DS3231Batch_h
+#define DS3231Batch_h
+
+#include <DS3231.h>
+
+#ifndef DS3231_BATCH_THREADS
+#if defined(ARDUINO)
+#define DS3231_BATCH_THREADS 0
+#else
+#define DS3231_BATCH_THREADS 1
+#endif
+#endif
+
+namespace DS3231Batch {
+    // One array per field, each with room for the number of times
+    // converted. year is the full year, 2000-2136.
+    struct Fields {
+        uint16_t* year;
+        uint8_t* month;
+        uint8_t* day;
+        uint8_t* hour;
+        uint8_t* minute;
+        uint8_t* second;
+    };
+
+    // Fields starting at element offset of each array
+    Fields slice(const Fields& fields, size_t offset);
+
+    void toFields(const uint32_t* unixtime, const Fields& fields, size_t count);
+        // As DateTime(unixtime[i]) for every i, for times from 2000 on.
+    void toUnixtime(const Fields& fields, uint32_t* unixtime, size_t count);
+        // As DateTime(year[i], month[i], ...).unixtime() for every i, for
+        // valid dates of 2000-2099. Years below 2000 are taken as
+        // offsets from 2000, as by DateTime.
+
+#if DS3231_BATCH_THREADS
+    void toFieldsParallel(const uint32_t* unixtime, const Fields& fields, size_t count,
+                          unsigned threads = 0);
+    void toUnixtimeParallel(const Fields& fields, uint32_t* unixtime, size_t count,
+                            unsigned threads = 0);
+        // Same, with the arrays split over threads; 0 means one per
+        // processor. Small arrays are converted on the calling thread.
+#endif
+}
+
+#endif
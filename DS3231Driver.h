@@ -0,0 +1,197 @@
+/*
+ * DS3231Driver.h
+ *
+ * Header-only DS3231 access for a bus type and I2C address fixed at
+ * compile time.
+ *
+ * DS3231Driver<Bus, Address> calls the bus object directly, with no
+ * TwoWire reference and no virtual call in between, so the compiler can
+ * inline a whole register read and fold the register addresses and bit
+ * masks into it. Bus is TwoWire or any class with the same
+ * beginTransmission(), write(), endTransmission(), requestFrom() and
+ * read() functions: a software I2C library, a second hardware port, a
+ * host test mock.
+ *
+ * The DS3231 class does its register transfers and time conversion with
+ * the same code, instantiated for TwoWire, and adds its run-time address,
+ * mux channel and register shadow on top.
+ */
+
+#ifndef DS3231Driver_h
+#define DS3231Driver_h
+
+#include <DS3231.h>
+
+namespace DS3231Registers {
+    // Register addresses
+    constexpr uint8_t Seconds = 0x00;       // 0x00-0x06: time, see decodeTime()
+    constexpr uint8_t Alarm1 = 0x07;        // 0x07-0x0A
+    constexpr uint8_t Alarm2 = 0x0B;        // 0x0B-0x0D
+    constexpr uint8_t Control = 0x0E;
+    constexpr uint8_t Status = 0x0F;
+    constexpr uint8_t AgingOffset = 0x10;
+    constexpr uint8_t Temperature = 0x11;   // 0x11-0x12
+    constexpr uint8_t Count = 0x13;
+
+    // Status register bits
+    constexpr uint8_t OSF = 0x80;
+    constexpr uint8_t BSY = 0x04;
+    constexpr uint8_t A2F = 0x02;
+    constexpr uint8_t A1F = 0x01;
+
+    // Bits of registers 0x00-0x06 that hold the time in 24-hour mode,
+    // register 0x00 in the low byte
+    constexpr uint64_t TimeBits = 0x00FF1F3F073F7F7FULL;
+
+#if DS3231_BCD_SWAR
+    // Decoded registers 0x00-0x06, one per byte, as a DateTime
+    constexpr DateTime timeFromLanes(uint64_t lanes) {
+        return DateTime(2000 + (uint8_t)(lanes >> 48), (uint8_t)(lanes >> 40),
+                        (uint8_t)(lanes >> 32), (uint8_t)(lanes >> 16),
+                        (uint8_t)(lanes >> 8), (uint8_t)lanes);
+    }
+
+    // Registers 0x00-0x06, in 24-hour mode, as a DateTime
+    constexpr DateTime decodeTime(const uint8_t* regs) {
+        return timeFromLanes(DS3231BCD::decodeLanes(DS3231BCD::pack8(regs, 7) & TimeBits));
+    }
+#else
+    // Registers 0x00-0x06, in 24-hour mode, as a DateTime
+    constexpr DateTime decodeTime(const uint8_t* regs) {
+        return DateTime(2000 + DS3231BCD::toDec(regs[6]), DS3231BCD::toDec(regs[5] & 0x1F),
+                        DS3231BCD::toDec(regs[4] & 0x3F), DS3231BCD::toDec(regs[2] & 0x3F),
+                        DS3231BCD::toDec(regs[1] & 0x7F), DS3231BCD::toDec(regs[0] & 0x7F));
+    }
+#endif
+
+    // A DateTime or EpochDateTime as registers 0x00-0x06, in 24-hour
+    // mode, with the day of the week counted from Monday = 1 to Sunday = 7
+    template <class Time>
+    inline void encodeTime(const Time& dt, uint8_t* regs) {
+        uint8_t dow = dt.dayOfTheWeek();
+        uint8_t fields[7] = { dt.second(), dt.minute(), dt.hour(), (uint8_t)(dow == 0 ? 7 : dow),
+                              dt.day(), dt.month(), (uint8_t)(dt.year() - 2000) };
+        DS3231BCD::encodeBlock(fields, regs, 7);
+    }
+}
+
+// Register transfers on a bus with the TwoWire interface. The *Status()
+// functions return DS3231::BusOk or the reason for the failure; read()
+// and write() return false on any failure.
+template <class Bus>
+struct DS3231Transfer {
+    static DS3231::BusStatus wireStatus(uint8_t code) {
+        // endTransmission(): 2 address NACK, 3 data NACK, 5 timeout
+        // (cores with setWireTimeout()), anything else a bus error
+        return code == 0 ? DS3231::BusOk
+            : code == 2 || code == 3 ? DS3231::BusNack
+            : code == 5 ? DS3231::BusTimeout : DS3231::BusError;
+    }
+
+    static DS3231::BusStatus readStatus(Bus & bus, uint8_t address, uint8_t reg, uint8_t* buffer, uint8_t count) {
+        bus.beginTransmission(address);
+        bus.write(reg);
+        DS3231::BusStatus status = wireStatus(bus.endTransmission());
+
+        uint8_t received = bus.requestFrom((int)address, (int)count);
+        for (uint8_t i = 0; i < count; i++) {
+            buffer[i] = bus.read();
+        }
+        return status != DS3231::BusOk ? status
+            : received != count ? DS3231::BusShortRead : DS3231::BusOk;
+    }
+
+    static DS3231::BusStatus writeStatus(Bus & bus, uint8_t address, uint8_t reg, const uint8_t* buffer, uint8_t count) {
+        bus.beginTransmission(address);
+        bus.write(reg);
+        for (uint8_t i = 0; i < count; i++) {
+            bus.write(buffer[i]);
+        }
+        return wireStatus(bus.endTransmission());
+    }
+
+    static bool read(Bus & bus, uint8_t address, uint8_t reg, uint8_t* buffer, uint8_t count) {
+        return readStatus(bus, address, reg, buffer, count) == DS3231::BusOk;
+    }
+
+    static bool write(Bus & bus, uint8_t address, uint8_t reg, const uint8_t* buffer, uint8_t count) {
+        return writeStatus(bus, address, reg, buffer, count) == DS3231::BusOk;
+    }
+};
+
+template <class Bus, uint8_t Address = 0x68>
+class DS3231Driver {
+    public:
+        explicit DS3231Driver(Bus & bus) : _bus(bus) {}
+
+        static constexpr uint8_t getAddress() { return Address; }
+        Bus & getBus() const { return _bus; }
+
+        bool read(uint8_t reg, uint8_t* buffer, uint8_t count) {
+            return DS3231Transfer<Bus>::read(_bus, Address, reg, buffer, count);
+        }
+        bool write(uint8_t reg, const uint8_t* buffer, uint8_t count) {
+            return DS3231Transfer<Bus>::write(_bus, Address, reg, buffer, count);
+        }
+            // Burst transfer of count registers starting at reg. Return
+            // false on a bus error.
+
+        bool now(DateTime& dt) {
+            uint8_t regs[7];
+            if (!read(DS3231Registers::Seconds, regs, 7)) {
+                return false;
+            }
+            dt = DS3231Registers::decodeTime(regs);
+            return true;
+        }
+            // Reads the time in one burst. The DS3231 must be in 24-hour
+            // mode.
+        bool adjust(const DateTime& dt) {
+            uint8_t regs[7];
+            DS3231Registers::encodeTime(dt, regs);
+            return write(DS3231Registers::Seconds, regs, 7);
+        }
+            // Sets the time in 24-hour mode, as DS3231::adjust().
+
+        bool getTemperatureQuarters(int16_t& quarters) {
+            uint8_t regs[2];
+            if (!read(DS3231Registers::Temperature, regs, 2)) {
+                return false;
+            }
+            quarters = (int16_t)((uint16_t)regs[0] << 8 | (regs[1] & 0xC0)) >> 6;
+            return true;
+        }
+            // Temperature in quarter degrees Celsius.
+
+        bool checkIfAlarm(uint8_t Alarm, bool clearflag = true) {
+            uint8_t flag = Alarm == 1 ? DS3231Registers::A1F : DS3231Registers::A2F;
+            uint8_t status;
+            if (!read(DS3231Registers::Status, &status, 1) || !(status & flag)) {
+                return false;
+            }
+            if (clearflag) {
+                // Ones leave the other flag set if it fired since the read.
+                status = (status | DS3231Registers::A1F | DS3231Registers::A2F) & ~flag;
+                if (!write(DS3231Registers::Status, &status, 1)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+            // As DS3231::checkIfAlarm(): true if the alarm flag is set,
+            // which is then cleared unless clearflag is false. Alarm 2
+            // unless Alarm is 1. False on a bus error, also when only
+            // the write clearing the flag failed.
+
+        bool oscillatorCheck() {
+            uint8_t status;
+            return read(DS3231Registers::Status, &status, 1) && !(status & DS3231Registers::OSF);
+        }
+            // False if the oscillator has stopped since the flag was last
+            // cleared, or on a bus error.
+
+    private:
+        Bus & _bus;
+};
+
+#endif
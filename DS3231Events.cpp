@@ -0,0 +1,96 @@
+/*
+DS3231Events.cpp: alarm interrupts queued by the pin interrupt and
+serviced with one status read and one flag write.
+
+Released into the public domain.
+*/
+
+#include "DS3231Events.h"
+
+// Stops the compiler from moving the store of an interrupt time after
+// the head that publishes it, or a load of one before the head is read.
+#define PUBLISH_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+DS3231Events::DS3231Events(DS3231 & rtc, uint32_t * buffer, uint8_t size)
+	: _rtc(rtc), _buffer(buffer), _size(size) {
+	_handlers[0] = 0;
+	_handlers[1] = 0;
+	clear();
+}
+
+void DS3231Events::setHandler(uint8_t Alarm, Handler handler) {
+	_handlers[Alarm == 1 ? 0 : 1] = handler;
+}
+
+void DS3231Events::onInterrupt() {
+	uint8_t head = _head;
+	uint8_t next = head + 1 == _size ? 0 : head + 1;
+	if (next == _tail) {
+		_dropped = _dropped + 1;
+		return;
+	}
+	_buffer[head] = millis();
+	PUBLISH_BARRIER();
+	_head = next;
+	uint8_t depth = next >= _tail ? next - _tail : next + _size - _tail;
+	if (depth > _maxDepth) {
+		_maxDepth = depth;
+	}
+}
+
+uint8_t DS3231Events::service() {
+	// The head is taken before the status is read: an interrupt after
+	// that belongs to the next service().
+	uint8_t head = _head;
+	uint8_t tail = _tail;
+	if (head == tail) {
+		return 0;
+	}
+	PUBLISH_BARRIER();
+	uint32_t time = _buffer[tail];
+	uint8_t fired = _rtc.checkAlarms(true);
+	if (_rtc.getLastError() != DS3231::BusOk) {
+		// Flags not read, or not cleared: keep the interrupts for the
+		// next try.
+		return 0;
+	}
+	// An alarm that fired between the read and the clear keeps its flag,
+	// and with it the pin low: no edge will announce it. Look again, and
+	// if a flag is set (or cannot be read), leave the last interrupt
+	// queued, with the time of this check, for the next service().
+	if (fired && (_rtc.checkAlarms(true, false) || _rtc.getLastError() != DS3231::BusOk)) {
+		tail = head == 0 ? _size - 1 : head - 1;
+		_buffer[tail] = millis();
+	} else {
+		tail = head;
+	}
+	_tail = tail;
+	for (uint8_t i = 0; i < 2; i++) {
+		if ((fired & (1 << i)) && _handlers[i]) {
+			_handlers[i](i + 1, time);
+		}
+	}
+	return fired;
+}
+
+uint8_t DS3231Events::getDepth() const {
+	uint8_t head = _head;
+	uint8_t tail = _tail;
+	return head >= tail ? head - tail : head + _size - tail;
+}
+
+uint16_t DS3231Events::getDropped() {
+	noInterrupts();
+	uint16_t dropped = _dropped;
+	interrupts();
+	return dropped;
+}
+
+void DS3231Events::clear() {
+	noInterrupts();
+	_head = 0;
+	_tail = 0;
+	_maxDepth = 0;
+	_dropped = 0;
+	interrupts();
+}
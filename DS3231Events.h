@@ -0,0 +1,95 @@
+/*
+ * DS3231Events.h
+ *
+ * Alarm events from the INT/SQW pin, serviced from loop().
+ *
+ * The interrupt handler of the pin calls onInterrupt(), which only stores
+ * millis() in a queue: no I2C in the interrupt. service(), from loop(),
+ * does nothing while the queue is empty. Otherwise it reads the control
+ * and status registers in one burst, clears the flags of the alarms that
+ * fired in one write, and calls the handler of each with the time of the
+ * interrupt. A second read then makes sure no alarm fired between the
+ * first read and the write: its flag would stay set, the pin low, and no
+ * new edge would come, so service() keeps an interrupt queued for it.
+ * That is two reads and one write for both alarms, against a read and a
+ * write per alarm with checkIfAlarm().
+ *
+ * The pin stays low until the flags are cleared, so normally only one
+ * interrupt waits at a time. More queue up when the flags are cleared
+ * elsewhere or the line is noisy; service() takes them all together, and
+ * the time passed on is that of the oldest. getMaxDepth() shows how far
+ * the queue filled, getDropped() how many interrupts found it full.
+ *
+ * The queue is a ring in an array supplied by the caller. Only the
+ * interrupt moves the head and only service() the tail, each a single
+ * byte, so neither side disables interrupts to use it.
+ *
+ * Hardware setup:
+ *   Connect the DS3231 INT/SQW pin to an interrupt-capable pin with a
+ *   pull-up and call onInterrupt() from an interrupt on the FALLING edge.
+ *   The alarms must be enabled with turnOnAlarm() or setAlarm(), which
+ *   also select the interrupt output instead of the square wave.
+ *
+ *   A flag already set when the interrupt is attached holds the pin low,
+ *   and no edge will ever come. Attach the interrupt first, then clear
+ *   the flags with checkAlarms().
+ */
+
+#ifndef DS3231Events_h
+#define DS3231Events_h
+
+#include <DS3231.h>
+
+class DS3231Events {
+	public:
+
+		typedef void (*Handler)(uint8_t alarm, uint32_t time);
+			// alarm is 1 or 2, time the millis() of the interrupt.
+
+		DS3231Events(DS3231 & rtc, uint32_t * buffer, uint8_t size);
+			// buffer holds size (2-255) interrupt times, at most
+			// size - 1 of them waiting.
+
+		void setHandler(uint8_t Alarm, Handler handler);
+			// Handler of Alarm 1, or 2 unless Alarm is 1; 0 for none.
+
+		// Producer: the pin interrupt
+		void onInterrupt();
+			// Queues the interrupt with the time from millis(), or counts
+			// a drop if the queue is full.
+
+		// Consumer: loop()
+		uint8_t service();
+			// Takes every waiting interrupt and runs the handlers of the
+			// alarms that fired. Returns those alarms, Alarm 1 in bit 0
+			// and Alarm 2 in bit 1; 0 with no bus access when nothing
+			// waits. If an alarm fires while it runs, one interrupt stays
+			// queued for it. On a bus error it returns 0 and runs no
+			// handler; the interrupts stay queued for the next call.
+		uint8_t getDepth() const;
+			// Interrupts waiting for service().
+		uint8_t getMaxDepth() const { return _maxDepth; }
+			// Most interrupts waiting at once since the last clear().
+		uint16_t getDropped();
+			// Interrupts not queued, the queue being full, since the last
+			// clear().
+		void clear();
+			// Empties the queue and resets the counters.
+
+	private:
+
+		DS3231 & _rtc;
+		uint32_t * _buffer;
+		uint8_t _size;
+		Handler _handlers[2];
+
+		// Written by the interrupt
+		volatile uint8_t _head;
+		volatile uint8_t _maxDepth;
+		volatile uint16_t _dropped;
+
+		// Written by service()
+		volatile uint8_t _tail;
+};
+
+#endif
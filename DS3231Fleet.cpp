@@ -0,0 +1,87 @@
+/*
+DS3231Fleet.cpp: reads many DS3231 clocks and finds their consensus time.
+
+Released into the public domain.
+*/
+
+#include "DS3231Fleet.h"
+
+// Marks a clock not read yet during a sweep. Neither it nor 0 can be a
+// DS3231 reading, which starts in 2000.
+#define PENDING 1
+
+DS3231Fleet::DS3231Fleet(DS3231 * const * clocks, uint32_t * times, uint8_t count) :
+	_clocks(clocks), _times(times), _count(count), _consensus(0) {
+	for (uint8_t i = 0; i < _count; i++) {
+		_times[i] = 0;
+	}
+}
+
+bool DS3231Fleet::sameRoute(uint8_t a, uint8_t b) const {
+	const DS3231 & x = *_clocks[a];
+	const DS3231 & y = *_clocks[b];
+	return &x._Wire == &y._Wire && x.getMuxAddress() == y.getMuxAddress()
+		&& (x.getMuxAddress() == 0 || x.getMuxChannel() == y.getMuxChannel());
+}
+
+uint8_t DS3231Fleet::read() {
+	DateTime dt;
+	uint8_t answered = 0;
+
+	for (uint8_t i = 0; i < _count; i++) {
+		_times[i] = PENDING;
+	}
+	// Take the first clock not yet read, then every other clock on the
+	// same route, so each mux channel is selected once.
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_times[i] != PENDING) continue;
+		for (uint8_t j = i; j < _count; j++) {
+			if (_times[j] != PENDING || !sameRoute(i, j)) continue;
+			if (_clocks[j]->now(dt)) {
+				_times[j] = dt.unixtime();
+				answered++;
+			} else {
+				_times[j] = 0;
+			}
+		}
+	}
+	return answered;
+}
+
+uint8_t DS3231Fleet::sweep() {
+	DateTime dt;
+	uint8_t answered = read();
+
+	// The first clock read is clock 0 unless it failed; read it again to
+	// see whether a second went by during the sweep.
+	for (uint8_t i = 0; i < _count; i++) {
+		if (!isValid(i)) continue;
+		if (_clocks[i]->now(dt) && dt.unixtime() != _times[i]) {
+			answered = read();
+		}
+		break;
+	}
+	_consensus = median();
+	return answered;
+}
+
+uint32_t DS3231Fleet::median() const {
+	// Selection by counting; fleets are small and this needs no storage.
+	uint8_t valid = 0;
+	for (uint8_t i = 0; i < _count; i++) {
+		if (isValid(i)) valid++;
+	}
+	if (valid == 0) return 0;
+	uint8_t rank = (valid - 1) / 2;
+	for (uint8_t i = 0; i < _count; i++) {
+		if (!isValid(i)) continue;
+		uint8_t below = 0, equal = 0;
+		for (uint8_t j = 0; j < _count; j++) {
+			if (!isValid(j)) continue;
+			if (_times[j] < _times[i]) below++;
+			else if (_times[j] == _times[i]) equal++;
+		}
+		if (below <= rank && rank < below + equal) return _times[i];
+	}
+	return 0;
+}
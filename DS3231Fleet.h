@@ -0,0 +1,59 @@
+/*
+ * DS3231Fleet.h
+ *
+ * Reads many DS3231 clocks, on one or more buses and behind I2C
+ * multiplexers, and compares them.
+ *
+ * A sweep reads each clock with one burst read. Clocks behind the same
+ * mux channel are read one after another, so every channel is selected
+ * once per sweep. The median of the readings serves as the consensus
+ * time, and each clock's offset is measured against it.
+ *
+ * The clocks and a results array of the same length are supplied by the
+ * caller:
+ *
+ *   DS3231 rack[] = { DS3231(Wire, 0x68, 0x70, 0), DS3231(Wire, 0x68, 0x70, 1) };
+ *   DS3231 * clocks[] = { &rack[0], &rack[1] };
+ *   uint32_t times[2];
+ *   DS3231Fleet fleet(clocks, times, 2);
+ */
+
+#ifndef DS3231Fleet_h
+#define DS3231Fleet_h
+
+#include <DS3231.h>
+
+class DS3231Fleet {
+	public:
+
+		DS3231Fleet(DS3231 * const * clocks, uint32_t * times, uint8_t count);
+
+		uint8_t sweep();
+			// Reads every clock and returns how many answered. If the
+			// first clock read has ticked by the end of the sweep, so that
+			// the readings straddle a second, the sweep is repeated once.
+		uint8_t count() const { return _count; }
+
+		bool isValid(uint8_t i) const { return _times[i] != 0; }
+			// Whether clock i answered in the last sweep.
+		uint32_t getTime(uint8_t i) const { return _times[i]; }
+			// Unix time read from clock i, 0 if it did not answer.
+		uint32_t getConsensus() const { return _consensus; }
+			// Median of the valid readings (the lower middle one for an
+			// even number), 0 if none.
+		long getOffset(uint8_t i) const { return isValid(i) ? (long)(int32_t)(_times[i] - _consensus) : 0; }
+			// Seconds clock i is ahead of the consensus; 0 if not valid.
+
+	private:
+
+		DS3231 * const * _clocks;
+		uint32_t * _times;
+		uint8_t _count;
+		uint32_t _consensus;
+
+		uint8_t read();
+		bool sameRoute(uint8_t a, uint8_t b) const;
+		uint32_t median() const;
+};
+
+#endif
@@ -0,0 +1,251 @@
+/*
+DS3231Journal.cpp: ring buffer of delta-encoded timestamps, safe to append
+to from an interrupt.
+
+Released into the public domain.
+*/
+
+#include "DS3231Journal.h"
+
+// First tag byte of a two-byte delta
+#define LONG_DELTA 0xF0
+// Checkpoint tag, followed by the Unix time
+#define CHECKPOINT 0xFF
+// Largest delta of a two-byte record
+#define MAX_DELTA (LONG_DELTA + ((uint32_t)(CHECKPOINT - LONG_DELTA) << 8) - 1)
+
+// Keeps the compiler from moving the record bytes past the store to
+// _head that publishes them.
+#define PUBLISH_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+DS3231Journal::DS3231Journal(uint8_t* buffer, uint16_t size, uint8_t checkpointInterval)
+	: _buffer(buffer), _size(size), _interval(checkpointInterval ? checkpointInterval : 1) {
+	clear();
+}
+
+bool DS3231Journal::append(uint32_t unixtime) {
+	uint8_t record[5];
+	uint8_t length;
+	uint32_t delta = unixtime - _lastTime;
+	if (_sinceCheckpoint >= _interval || unixtime < _lastTime || delta > MAX_DELTA) {
+		record[0] = CHECKPOINT;
+		for (uint8_t i = 0; i < 4; i++) {
+			record[1 + i] = (uint8_t)(unixtime >> (8 * i));
+		}
+		length = 5;
+	} else if (delta < LONG_DELTA) {
+		record[0] = (uint8_t)delta;
+		length = 1;
+	} else {
+		delta -= LONG_DELTA;
+		record[0] = (uint8_t)(LONG_DELTA + (delta >> 8));
+		record[1] = (uint8_t)delta;
+		length = 2;
+	}
+
+	// The consumer only moves _tail forward, so the room can only grow
+	// while this runs.
+	uint16_t head = _head;
+	uint16_t tail = _tail;
+	uint16_t used = head >= tail ? head - tail : head + _size - tail;
+	if (_size - 1 - used < length) {
+		_dropped = _dropped + 1;
+		return false;
+	}
+	if (length == 5) {
+		// Before the head moves: the consumer skips an entry for a
+		// timestamp it cannot see yet.
+		noteCheckpoint(head, tail, used);
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		_buffer[head] = record[i];
+		if (++head == _size) {
+			head = 0;
+		}
+	}
+	_lastTime = unixtime;
+	_sinceCheckpoint = length == 5 ? 1 : _sinceCheckpoint + 1;
+
+	PUBLISH_BARRIER();
+	_head = head;
+	_appended = _appended + 1;
+	return true;
+}
+
+void DS3231Journal::noteCheckpoint(uint16_t pos, uint16_t tail, uint16_t used) {
+	// The entries are oldest first; those the consumer has read past are
+	// dropped from the front.
+	uint8_t stale = 0;
+	while (stale < _indexUsed) {
+		uint16_t at = _index[stale].pos;
+		if ((at >= tail ? at - tail : at + _size - tail) < used) break;
+		stale++;
+	}
+	if (stale) {
+		_indexUsed -= stale;
+		for (uint8_t i = 0; i < _indexUsed; i++) {
+			_index[i] = _index[i + stale];
+		}
+		if (_indexUsed <= DS3231_JOURNAL_INDEX / 4 && _indexStride > 1) {
+			_indexStride /= 2;
+		}
+	}
+
+	// Every _indexStride-th checkpoint is noted. When the table is full,
+	// every other entry goes and the stride doubles, so the entries stay
+	// spread over the whole ring.
+	if (++_sinceIndexed < _indexStride) {
+		return;
+	}
+	_sinceIndexed = 0;
+	if (_indexUsed == DS3231_JOURNAL_INDEX) {
+		_indexUsed = DS3231_JOURNAL_INDEX / 2;
+		for (uint8_t i = 1; i < _indexUsed; i++) {
+			_index[i] = _index[2 * i];
+		}
+		_indexStride *= 2;
+	}
+	_index[_indexUsed].pos = pos;
+	_index[_indexUsed].number = _appended;
+	_indexUsed++;
+}
+
+uint8_t DS3231Journal::next(uint16_t& pos) const {
+	uint8_t value = _buffer[pos];
+	if (++pos == _size) {
+		pos = 0;
+	}
+	return value;
+}
+
+uint32_t DS3231Journal::decode(uint16_t& pos, uint32_t previous) const {
+	uint8_t tag = next(pos);
+	if (tag == CHECKPOINT) {
+		uint32_t unixtime = 0;
+		for (uint8_t i = 0; i < 4; i++) {
+			unixtime |= (uint32_t)next(pos) << (8 * i);
+		}
+		return unixtime;
+	}
+	if (tag >= LONG_DELTA) {
+		return previous + LONG_DELTA + ((uint16_t)(tag - LONG_DELTA) << 8 | next(pos));
+	}
+	return previous + tag;
+}
+
+bool DS3231Journal::read(uint32_t& unixtime) {
+	uint16_t head, count;
+	snapshot(head, count);
+	if (_tail == head) {
+		return false;
+	}
+	uint16_t tail = _tail;
+	_readTime = decode(tail, _readTime);
+	if (_peekNumber == _removed) {
+		// peek() stopped at the timestamp removed; move it along
+		_peekPos = tail;
+		_peekNumber = _removed + 1;
+		_peekTime = _readTime;
+	}
+	_removed++;
+	noInterrupts();
+	_tail = tail;
+	interrupts();
+	unixtime = _readTime;
+	return true;
+}
+
+bool DS3231Journal::read(DateTime& dt) {
+	uint32_t unixtime;
+	if (!read(unixtime)) {
+		return false;
+	}
+	dt = DateTime(unixtime);
+	return true;
+}
+
+bool DS3231Journal::peek(uint16_t index, uint32_t& unixtime) {
+	uint16_t head, count;
+	snapshot(head, count);
+	if (index >= count) {
+		return false;
+	}
+	// Start from the oldest timestamp, or from a later point at or
+	// before index: where the previous peek() stopped (never behind the
+	// tail, see read()) or an indexed checkpoint. Each is counted in
+	// timestamps from the tail; a checkpoint that has been read since
+	// wraps around to a large count and is passed over.
+	uint16_t pos = _tail;
+	uint16_t start = 0;
+	uint32_t t = _readTime;
+	uint16_t offset = _peekNumber - _removed;
+	if (offset <= index + 1) {
+		pos = _peekPos;
+		start = offset;
+		t = _peekTime;
+	}
+	noInterrupts();
+	for (uint8_t i = 0; i < _indexUsed; i++) {
+		offset = _index[i].number - _removed;
+		if (offset <= index && offset > start) {
+			pos = _index[i].pos;
+			start = offset;
+		}
+	}
+	interrupts();
+	for (; start <= index; start++) {
+		t = decode(pos, t);
+	}
+	_peekPos = pos;
+	_peekNumber = _removed + start;
+	_peekTime = t;
+	unixtime = t;
+	return true;
+}
+
+uint16_t DS3231Journal::available() {
+	uint16_t head, count;
+	snapshot(head, count);
+	return count;
+}
+
+uint16_t DS3231Journal::bytesUsed() {
+	uint16_t head, count;
+	snapshot(head, count);
+	return head >= _tail ? head - _tail : head + _size - _tail;
+}
+
+uint16_t DS3231Journal::getDropped() {
+	noInterrupts();
+	uint16_t dropped = _dropped;
+	interrupts();
+	return dropped;
+}
+
+void DS3231Journal::clear() {
+	noInterrupts();
+	_head = 0;
+	_appended = 0;
+	_dropped = 0;
+	_lastTime = 0;
+	_sinceCheckpoint = _interval;
+	_tail = 0;
+	_removed = 0;
+	_readTime = 0;
+	_indexUsed = 0;
+	_indexStride = 1;
+	_sinceIndexed = 0;
+	_peekPos = 0;
+	_peekNumber = 0;
+	_peekTime = 0;
+	interrupts();
+}
+
+void DS3231Journal::snapshot(uint16_t& head, uint16_t& count) {
+	// The head and the count are updated by the producer; copy them in
+	// one piece.
+	noInterrupts();
+	head = _head;
+	count = _appended - _removed;
+	interrupts();
+}
@@ -0,0 +1,121 @@
+/*
+ * DS3231Journal.h
+ *
+ * Compact ring buffer of timestamps for high-rate event logging.
+ *
+ * A Unix time takes four bytes, a DateTime six. Timestamps from one event
+ * source are mostly close together, so the journal stores a full time
+ * only now and then (a checkpoint) and otherwise the number of seconds
+ * since the previous timestamp:
+ *
+ *   0x00-0xEF           one byte: 0 to 239 seconds
+ *   0xF0-0xFE, low      two bytes: 240 to 4079 seconds
+ *   0xFF, 4 bytes       checkpoint: the Unix time, least significant
+ *                       byte first
+ *
+ * A checkpoint is written for the first timestamp, every
+ * checkpointInterval timestamps, and whenever the time goes backwards or
+ * jumps by more than 4079 seconds. Once a second that is a little over
+ * one byte per timestamp.
+ *
+ * The storage is an array supplied by the caller. append() may be called
+ * from an interrupt and everything else from loop(): the interrupt only
+ * writes at the head, loop() only reads at the tail, and the few shared
+ * counters are copied with interrupts disabled. When the ring is full,
+ * new timestamps are refused and counted, never written over old ones.
+ *
+ * append() also notes where checkpoints start, in a table of
+ * DS3231_JOURNAL_INDEX entries (8 unless defined before including this
+ * file, 4 bytes each) spread over the whole ring: when it fills up, every
+ * other entry is dropped and only every second checkpoint noted from then
+ * on. peek() decodes from the nearest entry before the timestamp asked
+ * for, which is within about available() / DS3231_JOURNAL_INDEX * 2
+ * records. It also remembers where it stopped, so peeking at index 0, 1,
+ * 2 and so on decodes one record per call.
+ */
+
+#ifndef DS3231Journal_h
+#define DS3231Journal_h
+
+#include <DS3231.h>
+
+#ifndef DS3231_JOURNAL_INDEX
+#define DS3231_JOURNAL_INDEX 8
+#endif
+
+class DS3231Journal {
+	public:
+
+		DS3231Journal(uint8_t* buffer, uint16_t size, uint8_t checkpointInterval = 64);
+			// buffer holds size bytes, at most size - 1 of them in use.
+			// checkpointInterval is the most timestamps (1-255) from one
+			// checkpoint to the next.
+
+		// Producer: one interrupt handler, or loop()
+		bool append(uint32_t unixtime);
+		bool append(const DateTime& dt) { return append(dt.unixtime()); }
+			// Adds a timestamp. Returns false, and counts a drop, if the
+			// ring has no room for it.
+
+		// Consumer: loop()
+		bool read(uint32_t& unixtime);
+		bool read(DateTime& dt);
+			// Removes the oldest timestamp. Return false if the journal
+			// is empty.
+		bool peek(uint16_t index, uint32_t& unixtime);
+			// Timestamp number index, 0 being the oldest, without
+			// removing anything. Decodes from the nearest indexed
+			// checkpoint or the previous peek() at or before index, else
+			// from the oldest timestamp.
+		uint16_t available();
+			// Timestamps in the journal.
+		uint16_t bytesUsed();
+			// Bytes in the journal; bytesUsed() / available() is the
+			// storage per timestamp.
+		uint16_t getCapacity() const { return _size - 1; }
+		uint16_t getDropped();
+			// Timestamps refused since the last clear().
+		void clear();
+			// Empties the journal and resets the drop count. The next
+			// timestamp starts with a checkpoint.
+
+	private:
+
+		uint8_t* _buffer;
+		uint16_t _size;
+		uint8_t _interval;
+
+		// Written by the producer
+		volatile uint16_t _head;
+		volatile uint16_t _appended;
+		volatile uint16_t _dropped;
+		uint32_t _lastTime;
+		uint8_t _sinceCheckpoint;
+		struct Checkpoint {
+			uint16_t pos;		// byte offset of the 0xFF tag
+			uint16_t number;	// timestamps appended before it
+		};
+		Checkpoint _index[DS3231_JOURNAL_INDEX];	// oldest first
+		uint8_t _indexUsed;
+		uint16_t _indexStride;		// checkpoints per entry
+		uint16_t _sinceIndexed;
+
+		// Written by the consumer
+		volatile uint16_t _tail;
+		uint16_t _removed;
+		uint32_t _readTime;
+			// Time of the last timestamp removed, the base of a delta
+			// at the tail
+		uint16_t _peekPos;
+		uint16_t _peekNumber;
+		uint32_t _peekTime;
+			// Where the last peek() stopped, or the tail: the record of
+			// timestamp number _peekNumber, and the time before it
+
+		void snapshot(uint16_t& head, uint16_t& count);
+		uint8_t next(uint16_t& pos) const;
+		uint32_t decode(uint16_t& pos, uint32_t previous) const;
+		void noteCheckpoint(uint16_t pos, uint16_t tail, uint16_t used);
+};
+
+#endif
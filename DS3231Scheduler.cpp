@@ -0,0 +1,147 @@
+/*
+DS3231Scheduler.cpp: many software alarms multiplexed onto Alarm 1.
+
+Released into the public domain.
+*/
+
+#include "DS3231Scheduler.h"
+
+// A1M1-A1M4 all clear and DY/DT clear: alarm when date, hour, minute
+// and second match
+#define MATCH_DATE_TIME 0b00000000
+
+DS3231Scheduler::DS3231Scheduler(DS3231 & rtc, Entry * storage, uint8_t capacity) :
+	_rtc(rtc), _heap(storage), _capacity(capacity), _size(0), _lastId(0),
+	_programmed(0), _armed(false), _check(false) {
+}
+
+uint8_t DS3231Scheduler::add(uint32_t due, Callback callback, uint32_t period) {
+	if (_size >= _capacity) {
+		return 0;
+	}
+	// Next free id; there are fewer alarms than ids, so one is free.
+	bool used;
+	do {
+		if (++_lastId == 0) _lastId = 1;
+		used = false;
+		for (uint8_t i = 0; i < _size; i++) {
+			if (_heap[i].id == _lastId) used = true;
+		}
+	} while (used);
+
+	Entry entry = { due, period, callback, _lastId };
+	push(entry);
+	_check = true;
+	return _lastId;
+}
+
+bool DS3231Scheduler::cancel(uint8_t id) {
+	for (uint8_t i = 0; i < _size; i++) {
+		if (_heap[i].id == id) {
+			removeAt(i);
+			_check = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+uint8_t DS3231Scheduler::service() {
+	// One status read while nothing has happened; the flag is cleared
+	// only when set.
+	if (!_rtc.checkIfAlarm(1) && !_check) {
+		return 0;
+	}
+
+	DateTime dt;
+	if (!_rtc.now(dt)) {
+		_check = true;
+		return 0;
+	}
+	uint32_t now = dt.unixtime();
+	uint8_t count = 0;
+
+	while (_size && _heap[0].due <= now) {
+		Entry entry = _heap[0];
+		removeAt(0);
+		if (entry.period) {
+			// Skip the periods that went by unserviced.
+			entry.due += ((now - entry.due) / entry.period + 1) * entry.period;
+			push(entry);
+		}
+		entry.callback(entry.id);
+		count++;
+	}
+	_check = !program(now);
+	return count;
+}
+
+bool DS3231Scheduler::program(uint32_t now) {
+	// On a bus error nothing is recorded as done and false is returned,
+	// so the next service() tries again.
+	if (_size == 0) {
+		if (_armed) {
+			_rtc.turnOffAlarm(1);
+			if (_rtc.getLastError() != DS3231::BusOk) {
+				return false;
+			}
+			_armed = false;
+		}
+		_programmed = 0;
+		return true;
+	}
+	uint32_t due = _heap[0].due;
+	if (due != _programmed || !_armed) {
+		// The alarm and its enable bit in one write
+		DateTime dt(due);
+		DS3231AlarmConfig alarm = { dt.day(), dt.hour(), dt.minute(), dt.second(),
+			MATCH_DATE_TIME, false, false, false, true, false };
+		if (!_rtc.setAlarm(1, alarm)) {
+			return false;
+		}
+		_programmed = due;
+		_armed = true;
+	}
+	// An alarm due within a second may pass before the registers are
+	// written, and would then only match a month later; keep checking
+	// the time instead. (Alarms later than a month ahead fire early on
+	// the same date and are simply re-armed.)
+	return due > now + 1;
+}
+
+void DS3231Scheduler::push(const Entry & entry) {
+	_heap[_size] = entry;
+	siftUp(_size++);
+}
+
+void DS3231Scheduler::removeAt(uint8_t i) {
+	_heap[i] = _heap[--_size];
+	if (i < _size) {
+		siftDown(i);
+		siftUp(i);
+	}
+}
+
+void DS3231Scheduler::siftUp(uint8_t i) {
+	while (i > 0) {
+		uint8_t parent = (i - 1) / 2;
+		if (_heap[parent].due <= _heap[i].due) break;
+		Entry swap = _heap[parent];
+		_heap[parent] = _heap[i];
+		_heap[i] = swap;
+		i = parent;
+	}
+}
+
+void DS3231Scheduler::siftDown(uint8_t i) {
+	for (;;) {
+		uint16_t child = 2 * i + 1;
+		if (child >= _size) break;
+		if (child + 1 < _size && _heap[child + 1].due < _heap[child].due) child++;
+		if (_heap[i].due <= _heap[child].due) break;
+		Entry swap = _heap[child];
+		_heap[child] = _heap[i];
+		_heap[i] = swap;
+		i = child;
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * DS3231Scheduler.h
+ *
+ * Any number of one-shot and periodic alarms on top of DS3231 Alarm 1.
+ *
+ * The alarms are kept in a binary heap ordered by due time, in an array
+ * supplied by the caller. Alarm 1 is always programmed, with a date,
+ * hour, minute and second match, for the earliest one; it is rewritten
+ * only when the earliest alarm changes.
+ *
+ * Call service() from loop(): after the INT/SQW pin has gone low, or
+ * simply every pass. It costs one register read while nothing is due.
+ * When Alarm 1 has fired, service() runs the callbacks of every alarm
+ * that is due, in order, re-queues the periodic ones and programs the
+ * next alarm. Alarm 2 is left free for other uses.
+ */
+
+#ifndef DS3231Scheduler_h
+#define DS3231Scheduler_h
+
+#include <DS3231.h>
+
+class DS3231Scheduler {
+	public:
+
+		typedef void (*Callback)(uint8_t id);
+
+		struct Entry {
+			uint32_t due;		// Unix time
+			uint32_t period;	// seconds, 0 for a one-shot alarm
+			Callback callback;
+			uint8_t id;
+		};
+
+		DS3231Scheduler(DS3231 & rtc, Entry * storage, uint8_t capacity);
+
+		uint8_t add(uint32_t due, Callback callback, uint32_t period = 0);
+			// Schedules callback at Unix time due, and then every period
+			// seconds if period is not 0. Returns an id (1-255) that is
+			// passed to the callback, or 0 if the storage is full. An
+			// alarm already due runs at the next service().
+		bool cancel(uint8_t id);
+			// Removes an alarm. Returns false if there is no such alarm.
+			// A callback may cancel its own periodic alarm.
+		uint8_t size() const { return _size; }
+		uint32_t next() const { return _size ? _heap[0].due : 0; }
+			// Due time of the earliest alarm, 0 if none.
+
+		uint8_t service();
+			// Runs the alarms that are due and programs Alarm 1 for the
+			// next one. Returns the number of callbacks run.
+
+	private:
+
+		DS3231 & _rtc;
+		Entry * _heap;
+		uint8_t _capacity;
+		uint8_t _size;
+		uint8_t _lastId;
+
+		uint32_t _programmed;	// due time in Alarm 1, 0 if none
+		bool _armed;			// A1IE set
+		bool _check;			// read the time at the next service()
+
+		void push(const Entry & entry);
+		void removeAt(uint8_t i);
+		void siftUp(uint8_t i);
+		void siftDown(uint8_t i);
+		bool program(uint32_t now);
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+DS3231SoftClock.cpp: sub-second software clock disciplined by the DS3231
+1 Hz square wave.
+
+Between two SQW edges the time is interpolated from micros(), corrected
+for the measured error of the MCU oscillator. The RTC itself is read only
+to anchor the edge count.
+
+Released into the public domain.
+*/
+
+#include "DS3231SoftClock.h"
+
+// Edges to wait before the first rate measurement
+#define FIRST_RESYNC_EDGES 10
+// Largest MCU clock error accepted, in ppm
+#define MAX_DRIFT_PPM 20000L
+
+DS3231SoftClock::DS3231SoftClock(DS3231 & rtc) : _rtc(rtc), _edgeCount(0),
+	_edgeMicros(0), _anchorEdge(0), _anchorSeconds(0), _anchorMicros(0),
+	_anchored(false), _haveRate(false), _resyncInterval(600), _ppm(0),
+	_divisor(1000000L >> 6) {
+}
+
+void DS3231SoftClock::begin(bool battery) {
+	// 1 Hz square wave on the SQW pin
+	_rtc.enableOscillator(true, battery, 0);
+	_anchored = false;
+}
+
+void DS3231SoftClock::onEdge() {
+	onEdge(micros());
+}
+
+void DS3231SoftClock::onEdge(unsigned long edgeMicros) {
+	_edgeMicros = edgeMicros;
+	_edgeCount++;
+}
+
+void DS3231SoftClock::setResyncInterval(uint16_t seconds) {
+	if (seconds < 1) seconds = 1;
+	if (seconds > 3600) seconds = 3600;	// keeps micros() spans below 2^32
+	_resyncInterval = seconds;
+}
+
+bool DS3231SoftClock::update() {
+	uint32_t edges;
+	unsigned long edgeMicros;
+	snapshot(edges, edgeMicros);
+
+	if (_anchored) {
+		uint32_t span = edges - _anchorEdge;
+		uint16_t interval = _haveRate ? _resyncInterval : FIRST_RESYNC_EDGES;
+		// Where the last edge should have been, had none gone missing.
+		long offset = (long)(edgeMicros - _anchorMicros - span * (unsigned long)(1000000L + _ppm));
+		if (span < interval && offset < 500000L && offset > -500000L) {
+			return true;
+		}
+	}
+	return anchor();
+}
+
+bool DS3231SoftClock::anchor() {
+	uint32_t edges, check;
+	unsigned long edgeMicros, checkMicros;
+	snapshot(edges, edgeMicros);
+	if (edges == 0) return _anchored;
+
+	// Read only early in a second, so no edge can land during the read.
+	if (micros() - edgeMicros > 800000UL) return _anchored;
+	DateTime rtcNow;
+	if (!_rtc.now(rtcNow)) return _anchored;
+	snapshot(check, checkMicros);
+	if (check != edges) return _anchored;
+	uint32_t seconds = rtcNow.unixtime();
+
+	if (_anchored) {
+		uint32_t span = edges - _anchorEdge;
+		// Measure the rate only if no edge went missing in between.
+		if (span > 0 && span <= 3600 && seconds - _anchorSeconds == span) {
+			long error = (long)(edgeMicros - _anchorMicros - span * 1000000UL);
+			long ppm = error / (long)span;
+			if (ppm > -MAX_DRIFT_PPM && ppm < MAX_DRIFT_PPM) {
+				_ppm = ppm;
+				_divisor = (1000000L + _ppm) >> 6;
+				_haveRate = true;
+			}
+		}
+	}
+	_anchorEdge = edges;
+	_anchorSeconds = seconds;
+	_anchorMicros = edgeMicros;
+	_anchored = true;
+	return true;
+}
+
+bool DS3231SoftClock::now(uint32_t& seconds, uint32_t& microseconds) {
+	if (!_anchored) return false;
+	uint32_t edges;
+	unsigned long edgeMicros;
+	snapshot(edges, edgeMicros);
+
+	unsigned long elapsed = micros() - edgeMicros;
+	if (elapsed > 1100000UL) elapsed = 1100000UL;
+	// elapsed * 1e6 / (1e6 + ppm), without 64-bit arithmetic
+	elapsed -= ((long)(elapsed >> 6) * _ppm) / (long)_divisor;
+	if (elapsed > 999999UL) elapsed = 999999UL;
+
+	seconds = _anchorSeconds + (edges - _anchorEdge);
+	microseconds = elapsed;
+	return true;
+}
+
+uint32_t DS3231SoftClock::unixtime() {
+	uint32_t seconds, microseconds;
+	return now(seconds, microseconds) ? seconds : 0;
+}
+
+void DS3231SoftClock::snapshot(uint32_t& edges, unsigned long& edgeMicros) {
+	// The pair is updated by the interrupt; copy it in one piece.
+	noInterrupts();
+	edges = _edgeCount;
+	edgeMicros = _edgeMicros;
+	interrupts();
+}
@@ -0,0 +1,83 @@
+/*
+ * DS3231SoftClock.h
+ *
+ * Sub-second software clock disciplined by the DS3231 1 Hz square wave.
+ *
+ * The DS3231 only counts whole seconds, and reading it costs an I2C
+ * transaction. This class turns on the 1 Hz SQW output, latches micros()
+ * on every falling edge (the moment the seconds register increments) and
+ * interpolates between edges with no bus traffic at all. The RTC is read
+ * only to anchor the edge count to a Unix time, and again every few
+ * minutes to catch missed edges and to measure how fast the MCU's own
+ * oscillator runs against the RTC.
+ *
+ * Hardware setup:
+ *   Connect the DS3231 SQW pin to an interrupt-capable pin with a pull-up
+ *   and call onEdge() from an interrupt on the FALLING edge.
+ *
+ * Note: the SQW pin is shared with the alarm interrupt output, so the
+ * alarms cannot drive the pin while this clock is running.
+ */
+
+#ifndef DS3231SoftClock_h
+#define DS3231SoftClock_h
+
+#include <DS3231.h>
+
+class DS3231SoftClock {
+	public:
+
+		DS3231SoftClock(DS3231 & rtc);
+
+		void begin(bool battery = false);
+			// Starts the 1 Hz square wave. If battery is true it keeps
+			// running on battery power (BBSQW).
+		void onEdge();
+			// Call from the SQW falling-edge interrupt.
+		void onEdge(unsigned long edgeMicros);
+			// Same as onEdge(), with the capture time supplied by the
+			// caller, e.g. from an input-capture timer.
+		bool update();
+			// Call often from loop(). Anchors the edge count to the RTC
+			// when needed and re-estimates the MCU clock error.
+			// Returns true if the clock is synchronized.
+
+		bool now(uint32_t& seconds, uint32_t& microseconds);
+			// Interpolated Unix time. Returns false (and leaves the
+			// arguments alone) until the first anchor has been taken.
+		uint32_t unixtime();
+			// Whole seconds only; 0 until synchronized.
+
+		void setResyncInterval(uint16_t seconds);
+			// How many edges may pass between RTC reads (1 to 3600,
+			// default 600).
+		long getDrift() const { return _ppm; }
+			// Measured MCU clock error in ppm, positive when micros()
+			// runs fast compared to the DS3231.
+		bool isSynchronized() const { return _anchored; }
+
+	private:
+
+		DS3231 & _rtc;
+
+		// Written by the interrupt
+		volatile uint32_t _edgeCount;
+		volatile unsigned long _edgeMicros;
+
+		// Anchor: the Unix time of edge number _anchorEdge
+		uint32_t _anchorEdge;
+		uint32_t _anchorSeconds;
+		unsigned long _anchorMicros;
+		bool _anchored;
+		bool _haveRate;
+
+		uint16_t _resyncInterval;
+		long _ppm;
+		unsigned long _divisor;
+			// (1000000 + _ppm) / 64, cached for the interpolation
+
+		void snapshot(uint32_t& edges, unsigned long& edgeMicros);
+		bool anchor();
+};
+
+#endif
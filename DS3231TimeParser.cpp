@@ -0,0 +1,184 @@
+/*
+DS3231TimeParser.cpp: incremental ISO 8601 and YYMMDDwHHMMSSx parser.
+
+Each format is described by a pattern string. A letter stands for one
+digit of a field, anything else for a separator that must match. The
+first four characters are digits in both formats, so the format is
+decided by the fifth: '-' for ISO 8601, a digit for the compact form.
+
+Released into the public domain.
+*/
+
+#include "DS3231TimeParser.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#elif defined(ESP8266)
+#include <pgmspace.h>
+#endif
+
+enum { Start, Lead, Fields, End, Fraction, Skip };
+
+static const char isoPattern[] PROGMEM = "YYYY-MM-DDThh:mm:ss";
+static const char compactPattern[] PROGMEM = "YYMMDDwhhmmss";
+static const char fieldLetters[] PROGMEM = "YMDwhms";
+
+static const uint8_t daysInMonth[] PROGMEM = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+
+// Index of the field a pattern letter stands for, 7 for a separator
+static uint8_t fieldIndex(char p) {
+	uint8_t i = 0;
+	while (i < 7 && pgm_read_byte(fieldLetters + i) != p) i++;
+	return i;
+}
+
+static bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static bool isLineEnd(char c) {
+	return c == '\n' || c == '\r';
+}
+
+DS3231TimeParser::DS3231TimeParser() : _valid(false), _year(0), _month(0),
+	_date(0), _dow(0), _hour(0), _minute(0), _second(0) {
+	reset();
+}
+
+void DS3231TimeParser::reset() {
+	_pattern = 0;
+	_pos = 0;
+	_state = Start;
+	for (uint8_t i = 0; i < 7; i++) {
+		_field[i] = 0;
+	}
+}
+
+DS3231TimeParser::Result DS3231TimeParser::fail() {
+	reset();
+	_state = Skip;
+	return Invalid;
+}
+
+DS3231TimeParser::Result DS3231TimeParser::feed(char c) {
+	// A line that ends part-way through a date and time is rejected, but
+	// the next line is read: skipping to the following line end would
+	// drop it.
+	if ((_state == Lead || _state == Fields) && isLineEnd(c)) {
+		reset();
+		return Invalid;
+	}
+	switch (_state) {
+	case Skip:
+		// Wait for the end of the bad line
+		if (isLineEnd(c) || c == 'x') {
+			_state = Start;
+		}
+		return Incomplete;
+
+	case Start:
+		if (c == ' ' || c == '\t' || isLineEnd(c)) {
+			return Incomplete;
+		}
+		_state = Lead;
+		// fall through
+
+	case Lead:
+		// The first four digits go into the year for now.
+		if (_pos < 4) {
+			if (!isDigit(c)) return fail();
+			_field[0] = _field[0] * 10 + (c - '0');
+			_pos++;
+			return Incomplete;
+		}
+		if (c == '-') {
+			_pattern = isoPattern;
+		} else if (isDigit(c)) {
+			// YYMM
+			_pattern = compactPattern;
+			_field[1] = _field[0] % 100;
+			_field[0] /= 100;
+		} else {
+			return fail();
+		}
+		_state = Fields;
+		// fall through
+
+	case Fields: {
+		char p = pgm_read_byte(_pattern + _pos);
+		uint8_t i = fieldIndex(p);
+		if (i < 7) {
+			if (!isDigit(c)) return fail();
+			_field[i] = _field[i] * 10 + (c - '0');
+		} else if (c != p && !(p == 'T' && c == ' ')) {
+			return fail();
+		}
+		if (pgm_read_byte(_pattern + ++_pos) == 0) {
+			_state = End;
+		}
+		return Incomplete;
+	}
+
+	case End:
+		if (_pattern == isoPattern && c == '.') {
+			_state = Fraction;
+			return Incomplete;
+		}
+		// fall through
+
+	case Fraction:
+		// Fractions of a second are read and dropped.
+		if (_state == Fraction && isDigit(c)) {
+			return Incomplete;
+		}
+		if (isLineEnd(c) || (_pattern == isoPattern ? c == 'Z' : c == 'x')) {
+			return finish();
+		}
+		return fail();
+	}
+	return fail();
+}
+
+DS3231TimeParser::Result DS3231TimeParser::finish() {
+	uint16_t year = _field[0];
+	bool iso = _pattern == isoPattern;
+
+	if (iso) {
+		if (year < 2000 || year > 2099) return fail();
+		year -= 2000;
+	}
+	if (_field[1] < 1 || _field[1] > 12) return fail();
+	uint8_t days = pgm_read_byte(daysInMonth + _field[1] - 1)
+			+ (_field[1] == 2 && isleapYear(year));
+	if (_field[2] < 1 || _field[2] > days) return fail();
+	if (!iso && (_field[3] < 1 || _field[3] > 7)) return fail();
+	if (_field[4] > 23 || _field[5] > 59 || _field[6] > 59) return fail();
+
+	_year = year;
+	_month = _field[1];
+	_date = _field[2];
+	_hour = _field[4];
+	_minute = _field[5];
+	_second = _field[6];
+	if (iso) {
+		// Monday = 1 ... Sunday = 7, as ISO 8601 numbers them
+		_dow = DateTime(_year, _month, _date).dayOfTheWeek();
+		if (_dow == 0) _dow = 7;
+	} else {
+		_dow = _field[3];
+	}
+	_valid = true;
+	reset();
+	return Complete;
+}
+
+bool DS3231TimeParser::apply(DS3231 & rtc) const {
+	if (!_valid) {
+		return false;
+	}
+	return rtc.setDateTime(_year, _month, _date, _dow, _hour, _minute, _second);
+}
+
+DateTime DS3231TimeParser::getDateTime() const {
+	return DateTime(_year, _month, _date, _hour, _minute, _second);
+}
@@ -0,0 +1,74 @@
+/*
+ * DS3231TimeParser.h
+ *
+ * Parses a date and time one character at a time, e.g. straight from
+ * Serial.read(), without buffering the line. Two formats are accepted:
+ *
+ *   ISO 8601      2024-06-15T12:30:00   ('T' or a space between date and
+ *                                        time, optional fraction and 'Z';
+ *                                        ends with 'Z', CR or LF)
+ *   Compact       240615612300x         (YYMMDDwHHMMSS, as read by the
+ *                                        DS3231_set example; ends with
+ *                                        'x', CR or LF)
+ *
+ * Every field is range-checked, including the day of the month. For ISO
+ * input the day of the week is calculated, Monday = 1 to Sunday = 7.
+ * Time zone offsets are not accepted.
+ *
+ * Uses no heap and no sscanf; the whole parser is a dozen bytes of state.
+ */
+
+#ifndef DS3231TimeParser_h
+#define DS3231TimeParser_h
+
+#include <DS3231.h>
+
+class DS3231TimeParser {
+	public:
+
+		enum Result {
+			Incomplete,	// more characters needed
+			Complete,	// a date and time has been read and checked
+			Invalid		// malformed or out of range; the rest of the
+						// line is skipped, if it has not ended already
+		};
+
+		DS3231TimeParser();
+
+		Result feed(char c);
+			// Feeds one character. Leading spaces and line ends are
+			// skipped. After Complete or Invalid the next character
+			// starts a new date and time.
+		void reset();
+			// Discards a partly read date and time.
+
+		bool apply(DS3231 & rtc) const;
+			// Writes the last complete date and time to the DS3231 in a
+			// single burst with setDateTime(). Returns false if nothing
+			// has been read yet, or on a bus error.
+
+		// The last complete date and time, as the DS3231 stores it
+		byte getYear() const { return _year; }		// 0 to 99
+		byte getMonth() const { return _month; }
+		byte getDate() const { return _date; }
+		byte getDoW() const { return _dow; }
+		byte getHour() const { return _hour; }
+		byte getMinute() const { return _minute; }
+		byte getSecond() const { return _second; }
+		DateTime getDateTime() const;
+
+	private:
+
+		Result finish();
+		Result fail();
+
+		const char * _pattern;	// in PROGMEM; 0 until the format is known
+		uint8_t _pos;
+		uint8_t _state;
+		uint16_t _field[7];		// being parsed: Y M D w h m s
+		bool _valid;
+
+		byte _year, _month, _date, _dow, _hour, _minute, _second;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/*
+DS3231TimeZone.cpp: UTC and local time for a rule-based time zone, from a
+table of the DST transitions of 2000-2099.
+
+Released into the public domain.
+*/
+
+#include "DS3231TimeZone.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#elif defined(ESP8266)
+#include <pgmspace.h>
+#endif
+
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+static const uint8_t daysInMonth [] PROGMEM = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+
+// First day of the month the rule can fall on; the transition is on one
+// of this and the next six days.
+static uint8_t firstCandidate(uint16_t year, const DS3231DstRule& rule) {
+	if (rule.week < 5) {
+		return 7 * rule.week - 6;
+	}
+	uint8_t days = pgm_read_byte(daysInMonth + rule.month - 1);
+	if (rule.month == 2 && isleapYear(year)) {
+		days++;
+	}
+	return days - 6;
+}
+
+static uint8_t candidateOffset(uint16_t year, const DS3231DstRule& rule) {
+	uint8_t dow = DateTime(year, rule.month, firstCandidate(year, rule)).dayOfTheWeek();
+	return (rule.dayOfWeek + 7 - dow) % 7;
+}
+
+DS3231TimeZone::DS3231TimeZone(int16_t offset) : _offset(offset), _dstShift(0),
+	_from(0), _until(0), _cachedOffset(offset) {
+}
+
+DS3231TimeZone::DS3231TimeZone(int16_t offset, int16_t dstShift, const DS3231DstRule& dstStart,
+	const DS3231DstRule& dstEnd) : _offset(offset), _dstShift(dstShift), _start(dstStart),
+	_end(dstEnd), _from(0), _until(0), _cachedOffset(offset) {
+	for (uint8_t y = 0; y < 100; y++) {
+		_days[y] = candidateOffset(2000 + y, _start) | candidateOffset(2000 + y, _end) << 3;
+	}
+}
+
+uint32_t DS3231TimeZone::transition(uint16_t year, bool start) const {
+	if (year < 2000) {
+		return 0;
+	}
+	if (year > 2099) {
+		return 0xFFFFFFFFUL;
+	}
+	const DS3231DstRule& rule = start ? _start : _end;
+	uint8_t packed = _days[year - 2000];
+	uint8_t day = firstCandidate(year, rule) + (start ? packed & 7 : packed >> 3);
+	// The rule gives the time in the offset that is about to end.
+	int32_t before = (int32_t)(start ? _offset : _offset + _dstShift) * 60;
+	return DateTime(year, rule.month, day).unixtime() + rule.minute * 60UL - before;
+}
+
+uint32_t DS3231TimeZone::getTransition(uint16_t year, bool start) {
+	return _dstShift == 0 ? 0 : transition(year, start);
+}
+
+void DS3231TimeZone::findInterval(uint32_t utc) {
+	// Between the transitions of the year of utc, or from one of them to
+	// the nearest one in the year before or after.
+	uint16_t year = utc < SECONDS_FROM_1970_TO_2000 ? 2000 : DateTime(utc).year();
+	uint32_t start = transition(year, true);
+	uint32_t end = transition(year, false);
+	bool dst;
+	if (start < end) {
+		if (utc < start) {
+			_from = transition(year - 1, false);
+			_until = start;
+			dst = false;
+		} else if (utc < end) {
+			_from = start;
+			_until = end;
+			dst = true;
+		} else {
+			_from = end;
+			_until = transition(year + 1, true);
+			dst = false;
+		}
+	} else {
+		if (utc < end) {
+			_from = transition(year - 1, true);
+			_until = end;
+			dst = true;
+		} else if (utc < start) {
+			_from = end;
+			_until = start;
+			dst = false;
+		} else {
+			_from = start;
+			_until = transition(year + 1, false);
+			dst = true;
+		}
+	}
+	_cachedOffset = dst ? _offset + _dstShift : _offset;
+}
+
+int16_t DS3231TimeZone::getOffset(uint32_t utc) {
+	if (_dstShift != 0 && (utc < _from || utc >= _until)) {
+		findInterval(utc);
+	}
+	return _cachedOffset;
+}
+
+bool DS3231TimeZone::isDst(uint32_t utc) {
+	return getOffset(utc) != _offset;
+}
+
+uint32_t DS3231TimeZone::toLocal(uint32_t utc) {
+	return utc + getOffset(utc) * 60L;
+}
+
+DateTime DS3231TimeZone::toLocal(const DateTime& utc) {
+	return DateTime(toLocal(utc.unixtime()));
+}
+
+uint32_t DS3231TimeZone::toUtc(uint32_t local) {
+	// Try DST first, so a repeated hour resolves to its first occurrence.
+	uint32_t utc = local - (_offset + _dstShift) * 60L;
+	if (getOffset(utc) == _offset + _dstShift) {
+		return utc;
+	}
+	return local - _offset * 60L;
+}
+
+DateTime DS3231TimeZone::toUtc(const DateTime& local) {
+	return DateTime(toUtc(local.unixtime()));
+}
@@ -0,0 +1,81 @@
+/*
+ * DS3231TimeZone.h
+ *
+ * Conversion between UTC and local time for one time zone, with or
+ * without daylight saving time, without localtime_r() or a TZ string
+ * parser.
+ *
+ * The zone is given as a standard offset and, for DST, the rules for the
+ * start and the end, in the form of a POSIX TZ string: "the last Sunday of
+ * March at 02:00". The constructor works out the day of every transition
+ * of 2000-2099 once and keeps it in one byte per year. A conversion then
+ * takes no searching: the year picks the table entry, and the interval
+ * between the transitions around the last time converted is cached, so
+ * converting the current time again is a comparison.
+ */
+
+#ifndef DS3231TimeZone_h
+#define DS3231TimeZone_h
+
+#include <DS3231.h>
+
+// Start or end of daylight saving time, as in a POSIX TZ string
+// (Mm.w.d/time)
+struct DS3231DstRule {
+	uint8_t month;			// 1-12
+	uint8_t week;			// 1-4, or 5 for the last one in the month
+	uint8_t dayOfWeek;		// 0 = Sunday, as DateTime::dayOfTheWeek()
+	uint16_t minute;		// local time of the change, in the time it ends,
+							// as minutes after midnight
+};
+
+class DS3231TimeZone {
+	public:
+
+		explicit DS3231TimeZone(int16_t offset);
+			// A zone without DST, offset minutes east of UTC.
+		DS3231TimeZone(int16_t offset, int16_t dstShift, const DS3231DstRule& dstStart,
+			const DS3231DstRule& dstEnd);
+			// Standard time offset minutes east of UTC, moved forward by
+			// dstShift minutes (usually 60) from dstStart to dstEnd. For
+			// the southern hemisphere dstEnd comes earlier in the year.
+
+		int16_t getOffset(uint32_t utc);
+			// Minutes east of UTC at the Unix time utc.
+		bool isDst(uint32_t utc);
+
+		uint32_t toLocal(uint32_t utc);
+		DateTime toLocal(const DateTime& utc);
+			// Local time, as a Unix-style timestamp or DateTime.
+		uint32_t toUtc(uint32_t local);
+		DateTime toUtc(const DateTime& local);
+			// UTC of a local time. A local time skipped by the start of
+			// DST is taken as standard time, one repeated by the end of
+			// DST as its first occurrence.
+
+		uint32_t getTransition(uint16_t year, bool start);
+			// Unix time of the start (or end) of DST in year 2000-2099;
+			// 0 for a zone without DST.
+
+	private:
+
+		int16_t _offset;
+		int16_t _dstShift;
+		DS3231DstRule _start;
+		DS3231DstRule _end;
+
+		uint8_t _days[100];
+			// Day of each transition, 2000-2099: start in bits 0-2, end in
+			// bits 3-5, each as days after the first day the rule allows
+
+		// Cached interval between two transitions
+		uint32_t _from;
+		uint32_t _until;
+		int16_t _cachedOffset;
+
+		uint32_t transition(uint16_t year, bool start) const;
+			// As getTransition(); 0 before 2000, 0xFFFFFFFF after 2099
+		void findInterval(uint32_t utc);
+};
+
+#endif
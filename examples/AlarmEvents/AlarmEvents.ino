@@ -0,0 +1,70 @@
+/*
+AlarmEvents.ino
+
+Both DS3231 alarms on the interrupt pin, without polling the flags.
+
+DS3231Events queues each falling edge of INT/SQW in the interrupt and
+service() reads and clears the alarm flags only when one has arrived,
+then calls the handler of each alarm that fired.
+
+Hardware setup:
+  Connect DS3231 SQW pin to Arduino interrupt pin 2
+
+*/
+
+#include <DS3231.h>
+#include <DS3231Events.h>
+#include <Wire.h>
+
+#define CLINT 2
+
+DS3231 myRTC;
+uint32_t interruptTimes[8];
+DS3231Events events(myRTC, interruptTimes, 8);
+
+void rtcInterrupt() {
+    events.onInterrupt();
+}
+
+void everySecond(uint8_t alarm, uint32_t time) {
+    Serial.print("Alarm ");
+    Serial.print(alarm);
+    Serial.print(" at ");
+    Serial.print(time);
+    Serial.println(" ms");
+}
+
+void everyMinute(uint8_t alarm, uint32_t time) {
+    everySecond(alarm, time);
+    Serial.print("Interrupts dropped: ");
+    Serial.print(events.getDropped());
+    Serial.print(", most waiting: ");
+    Serial.println(events.getMaxDepth());
+}
+
+void setup() {
+    Wire.begin();
+    Serial.begin(57600);
+
+    // Alarm 1 every second, Alarm 2 every minute, both on the pin
+    DS3231AlarmConfig alarm1 = { 0, 0, 0, 0, 0b00001111, false, false, false, true, false };
+    DS3231AlarmConfig alarm2 = { 0, 0, 0, 0, 0b01110000, false, false, false, true, false };
+    myRTC.setAlarm(1, alarm1);
+    myRTC.setAlarm(2, alarm2);
+
+    events.setHandler(1, everySecond);
+    events.setHandler(2, everyMinute);
+
+    pinMode(CLINT, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(CLINT), rtcInterrupt, FALLING);
+
+    // The pin only falls once both flags are clear. Clear them after
+    // attaching: a flag set in between would otherwise hold the pin low
+    // for good.
+    myRTC.checkAlarms();
+}
+
+void loop() {
+    // No I2C traffic until the pin has fallen.
+    events.service();
+}
@@ -0,0 +1,50 @@
+/*
+SetFromSerial.ino
+
+Sets the DS3231 from a date and time typed into the Serial Monitor, in
+either of two forms:
+
+  2024-06-15T12:30:00     ISO 8601, day of the week worked out (Monday = 1)
+  240615612300x           YYMMDDwHHMMSSx, as in the DS3231_set example
+
+Characters are handed to DS3231TimeParser as they arrive, so a long or
+garbled line cannot overrun a buffer. The date and time are checked
+before they are written, all at once, to the DS3231.
+
+Set the Serial Monitor to send a newline at the end of each line.
+
+*/
+
+#include <DS3231.h>
+#include <DS3231TimeParser.h>
+#include <Wire.h>
+
+DS3231 myRTC;
+DS3231TimeParser parser;
+
+void setup() {
+    Serial.begin(57600);
+    Wire.begin();
+    myRTC.setClockMode(false);  // 24-hour mode
+    Serial.println("Enter the date and time, e.g. 2024-06-15T12:30:00");
+}
+
+void loop() {
+    while (Serial.available()) {
+        switch (parser.feed(Serial.read())) {
+            case DS3231TimeParser::Complete:
+                if (parser.apply(myRTC)) {
+                    Serial.print("Clock set to ");
+                    Serial.println(parser.getDateTime().unixtime());
+                } else {
+                    Serial.println("The DS3231 did not answer");
+                }
+                break;
+            case DS3231TimeParser::Invalid:
+                Serial.println("Not a valid date and time");
+                break;
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/*
+SoftClock.ino
+
+Millisecond timestamps from a DS3231 without reading it over I2C every time.
+
+DS3231SoftClock turns on the 1 Hz square wave, counts its edges in an
+interrupt and interpolates between them with micros().
+
+Hardware setup:
+  Connect DS3231 SQW pin to Arduino interrupt pin 2
+
+*/
+
+#include <DS3231.h>
+#include <DS3231SoftClock.h>
+#include <Wire.h>
+
+#define SQW_PIN 2
+
+DS3231 myRTC;
+DS3231SoftClock softClock(myRTC);
+
+void sqwEdge() {
+    softClock.onEdge();
+}
+
+void setup() {
+    Wire.begin();
+    Serial.begin(57600);
+
+    pinMode(SQW_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(SQW_PIN), sqwEdge, FALLING);
+    softClock.begin();
+}
+
+void loop() {
+    uint32_t seconds, microseconds;
+
+    // Cheap; reads the RTC only now and then.
+    softClock.update();
+
+    if (softClock.now(seconds, microseconds)) {
+        Serial.print(seconds);
+        Serial.print('.');
+        uint16_t ms = microseconds / 1000;
+        if (ms < 100) Serial.print('0');
+        if (ms < 10) Serial.print('0');
+        Serial.print(ms);
+        Serial.print("  drift (ppm): ");
+        Serial.println(softClock.getDrift());
+    }
+    delay(250);
+}
@@ -0,0 +1,53 @@
+/*
+ * Arduino.h (host stand-in)
+ *
+ * Minimal subset of the Arduino core needed to compile the DS3231 library
+ * on a Linux host for the tests in this directory. Time is simulated: it
+ * only advances when a test calls mockAdvanceMicros() or delay().
+ */
+
+#ifndef DS3231_HOST_ARDUINO_h
+#define DS3231_HOST_ARDUINO_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+// Test controls for the simulated clock.
+void mockAdvanceMicros(unsigned long us);
+void mockSetMicros(unsigned long us);
+
+// Test controls for the simulated pins. A pin set to INPUT reads HIGH, as
+// an I2C line with a pull-up, unless a test holds it low.
+void mockHoldLow(uint8_t pin, bool hold);
+unsigned long mockPulses(uint8_t pin);
+	// Times the pin was driven LOW since the start
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * MockDS3231.h
+ *
+ * Register-level model of a DS3231 for host tests: register pointer with
+ * auto-increment, read-only and clear-only bits, a seconds counter with
+ * calendar rollover, alarm matching and CONV/BSY temperature conversions.
+ */
+
+#ifndef DS3231_HOST_MOCKDS3231_h
+#define DS3231_HOST_MOCKDS3231_h
+
+#include "Wire.h"
+
+class MockDS3231 : public MockI2CDevice {
+	public:
+		MockDS3231(uint8_t address = 0x68);
+
+		virtual void onWrite(const uint8_t* data, size_t n);
+		virtual size_t onRead(uint8_t* out, size_t n);
+
+		// Sets the time registers in 24-hour mode. Year is 0-99.
+		void setTime(uint8_t year, uint8_t month, uint8_t date, uint8_t dow,
+				uint8_t hour, uint8_t minute, uint8_t second);
+		// Advances the time registers, raising A1F/A2F on matches.
+		void advanceSeconds(unsigned long seconds);
+		// Value the next completed temperature conversion will report,
+		// in quarter degrees Celsius.
+		void setTemperatureQuarters(int16_t quarters);
+
+		uint8_t regs[0x13];
+		uint8_t pointer;
+		unsigned long conversionMicros;	// duration of a forced conversion
+		unsigned long conversionsStarted;
+
+	private:
+		void update();
+		void tick();
+		void checkAlarms();
+		int16_t nextTemperature;
+		bool converting;
+		unsigned long conversionStart;
+};
+
+#endif
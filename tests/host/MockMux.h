@@ -0,0 +1,34 @@
+/*
+ * MockMux.h
+ *
+ * A TCA9548A-style I2C multiplexer for host tests: one control byte
+ * whose bits connect channels 0-7 to the bus. Devices attached to open
+ * channels answer through it.
+ */
+
+#ifndef DS3231_HOST_MOCKMUX_h
+#define DS3231_HOST_MOCKMUX_h
+
+#include "Wire.h"
+
+#define MOCK_MUX_DEVICES 4	// per channel
+
+class MockMux : public MockI2CDevice {
+	public:
+		MockMux(uint8_t address = 0x70);
+
+		void attach(uint8_t channel, MockI2CDevice* device);
+
+		virtual MockI2CDevice* route(uint8_t address);
+		virtual void onWrite(const uint8_t* data, size_t n);
+		virtual size_t onRead(uint8_t* out, size_t n);
+
+		uint8_t control;
+		unsigned long selections;	// control register writes
+		unsigned long collisions;	// addresses answered on two open channels
+
+	private:
+		MockI2CDevice* children[8][MOCK_MUX_DEVICES];
+};
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Wire.h (host stand-in)
+ *
+ * A TwoWire look-alike that routes transactions to simulated I2C devices
+ * instead of hardware, and keeps count of what crossed the bus so tests
+ * can assert on transaction cost.
+ */
+
+#ifndef DS3231_HOST_WIRE_h
+#define DS3231_HOST_WIRE_h
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+#define WIRE_HAS_TIMEOUT
+
+class MockI2CDevice {
+	public:
+		MockI2CDevice(uint8_t address) : i2cAddress(address) {}
+		virtual ~MockI2CDevice() {}
+		virtual MockI2CDevice* route(uint8_t address) {
+			return address == i2cAddress ? this : 0;
+		}
+		// Called with the payload of a completed write transaction.
+		virtual void onWrite(const uint8_t* data, size_t n) = 0;
+		// Fills up to n bytes for a read transaction, returns bytes supplied.
+		virtual size_t onRead(uint8_t* out, size_t n) = 0;
+		uint8_t i2cAddress;
+};
+
+struct MockBusCounters {
+	unsigned long transactions;	// START ... STOP sequences
+	unsigned long writes;		// write transactions
+	unsigned long reads;		// read transactions
+	unsigned long bytesWritten;	// payload bytes, excluding the address byte
+	unsigned long bytesRead;
+	unsigned long bitTimes;		// SCL periods including START, ACK and STOP
+	unsigned long errors;		// NACKed or short transactions
+	unsigned long collisions;	// transactions answered by more than one device
+};
+
+class TwoWire {
+	public:
+		TwoWire();
+		void begin();
+		void end() {}
+		void setClock(uint32_t clock) { clockHz = clock; }
+		void setWireTimeout(uint32_t timeout = 25000, bool reset = false) { wireTimeout = timeout; wireTimeoutReset = reset; }
+		bool getWireTimeoutFlag() { return timeoutFlag; }
+		void clearWireTimeoutFlag() { timeoutFlag = false; }
+
+		void beginTransmission(uint8_t address);
+		void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+		size_t write(uint8_t data);
+		size_t write(const uint8_t* data, size_t quantity);
+		uint8_t endTransmission(uint8_t sendStop = true);
+
+		uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+		uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+		uint8_t requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop); }
+		int available();
+		int read();
+		int peek();
+
+		// Mock controls
+		void attach(MockI2CDevice* device);
+		void resetCounters();
+		void failNext(unsigned int count, unsigned int skip = 0) { failures = count; skips = skip; }
+			// The next count transactions fail, after skip that succeed
+		void hangNext(unsigned int count) { hangs = count; }
+			// The next count transactions hang until the Wire timeout
+		MockBusCounters counters;
+		unsigned long beginCount;	// calls to begin(), e.g. after bus recovery
+		uint32_t clockHz;			// simulated time advances with each transaction
+		uint32_t wireTimeout;		// microseconds, as set by setWireTimeout()
+		bool wireTimeoutReset;
+
+	private:
+		MockI2CDevice* find(uint8_t address);
+		void spend(unsigned long bits);
+		MockI2CDevice* devices[16];
+		uint8_t deviceCount;
+		uint8_t txAddress;
+		uint8_t txBuffer[BUFFER_LENGTH];
+		uint8_t txLength;
+		bool txOverflow;
+		uint8_t rxBuffer[BUFFER_LENGTH];
+		uint8_t rxLength;
+		uint8_t rxIndex;
+		unsigned int failures;
+		unsigned int skips;
+		unsigned int hangs;
+		bool timeoutFlag;
+		bool hang();
+		bool fail();
+};
+
+extern TwoWire Wire;
+
+#endif
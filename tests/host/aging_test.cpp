@@ -0,0 +1,116 @@
+/*
+ * aging_test.cpp
+ *
+ * Aging offset access and calibration against a simulated drifting RTC.
+ */
+
+#include <DS3231.h>
+#include <DS3231Aging.h>
+#include <math.h>
+#include <stdlib.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+// The simulated RTC runs fast by basePpm, less 0.1 ppm per offset step.
+struct DriftModel {
+	double basePpm;
+	double errorMicros;		// RTC time minus reference time
+	uint32_t seed;
+
+	double rate(int8_t offset) const { return basePpm - 0.1 * offset; }
+	void run(double seconds, int8_t offset) {
+		errorMicros += seconds * rate(offset);
+	}
+	// Reference timing noise, uniform in +-range milliseconds
+	int noise(int range) {
+		seed = seed * 1103515245UL + 12345UL;
+		return (int)((seed >> 16) % (2 * range + 1)) - range;
+	}
+};
+
+static const uint32_t start = 1700000000UL;
+
+static void observe(DS3231AgingCalibrator& cal, DriftModel& model,
+		uint32_t reference, bool millis) {
+	double rtc = reference + model.errorMicros / 1e6;
+	if (millis) {
+		double ms = floor(rtc * 1000 + 0.5) + model.noise(5);
+		uint32_t whole = (uint32_t)(ms / 1000);
+		cal.addObservation(reference, whole, 0, (uint16_t)(ms - whole * 1000.0));
+	} else {
+		cal.addObservation(reference, (uint32_t)floor(rtc));
+	}
+}
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	int8_t offset = 99;
+
+	// Register access
+	CHECK(rtc.getAgingOffset(offset));
+	CHECK_EQ(offset, 0);
+	CHECK(rtc.setAgingOffset(-20));
+	CHECK_EQ(chip.regs[0x10], 0xEC);
+	CHECK(rtc.getAgingOffset(offset));
+	CHECK_EQ(offset, -20);
+	Wire.failNext(1);
+	CHECK(!rtc.getAgingOffset(offset));
+	CHECK_EQ(offset, -20);
+	rtc.setAgingOffset(0);
+
+	// Hourly millisecond readings: converges within two days.
+	DS3231AgingCalibrator cal(rtc);
+	DriftModel model = { 3.7, 250000, 1 };
+	CHECK(!cal.apply());	// nothing to go on
+	CHECK(cal.getDriftError() < 0);
+	int hours = 0;
+	for (; hours < 24 * 30 && !cal.isConverged(); hours++) {
+		observe(cal, model, start + hours * 3600UL, true);
+		model.run(3600, 0);
+	}
+	CHECK(hours < 48);
+	CHECK(fabs(cal.getDrift() - 3.7) < 0.05);
+	CHECK_EQ(cal.getOffsetChange(), 37);
+
+	unsigned long conversions = chip.conversionsStarted;
+	CHECK(cal.apply());
+	CHECK_EQ((int8_t)chip.regs[0x10], 37);
+	CHECK_EQ(chip.conversionsStarted, conversions + 1);
+	CHECK_EQ(cal.count(), 0);
+
+	// With the new offset the clock keeps time; a second pass agrees.
+	for (hours = 0; hours < 24 * 30 && !cal.isConverged(); hours++) {
+		observe(cal, model, start + (100 + hours) * 3600UL, true);
+		model.run(3600, 37);
+	}
+	CHECK(fabs(cal.getDrift()) < 0.05);
+	CHECK_EQ(cal.getOffsetChange(), 0);
+
+	// Whole-second readings need a span of days, but get there.
+	cal.reset();
+	DriftModel slow = { -2.4, 0, 7 };
+	rtc.setAgingOffset(0);
+	for (hours = 0; hours < 24 * 60 && !cal.isConverged(); hours++) {
+		observe(cal, slow, start + hours * 3600UL, false);
+		slow.run(3600, 0);
+	}
+	CHECK(hours > 24 * 3);
+	CHECK(hours < 24 * 60);
+	CHECK(fabs(cal.getDrift() + 2.4) < 0.1);
+	CHECK(cal.apply());
+	CHECK(abs((int8_t)chip.regs[0x10] + 24) <= 1);
+
+	// The offset saturates instead of wrapping.
+	rtc.setAgingOffset(120);
+	DriftModel fast = { 30.0, 0, 3 };
+	for (hours = 0; hours < 48; hours++) {
+		observe(cal, fast, start + hours * 3600UL, true);
+		fast.run(3600, 0);
+	}
+	CHECK(cal.apply());
+	CHECK_EQ((int8_t)chip.regs[0x10], 127);
+
+	return checkReport("aging_test");
+}
@@ -0,0 +1,145 @@
+/*
+ * alarm_config_test.cpp
+ *
+ * DS3231AlarmConfig: getAlarms() and getAlarm() in one burst, against
+ * getA1Time()/getA2Time(); setAlarm() against setA1Time()/setA2Time() and
+ * turnOnAlarm(), in one write, leaving the other alarm and the rest of
+ * the control register alone.
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static void checkAlarm1(DS3231& rtc, const DS3231AlarmConfig& config) {
+	byte day, hour, minute, second, bits = 0;
+	bool dy, h12, pm = false;
+	rtc.getA1Time(day, hour, minute, second, bits, dy, h12, pm);
+	CHECK_EQ(config.day, day);
+	CHECK_EQ(config.hour, hour);
+	CHECK_EQ(config.minute, minute);
+	CHECK_EQ(config.second, second);
+	CHECK_EQ(config.alarmBits, bits);
+	CHECK_EQ(config.dayOfWeek, dy);
+	CHECK_EQ(config.h12, h12);
+	CHECK_EQ(config.pm, pm);
+}
+
+static void checkAlarm2(DS3231& rtc, const DS3231AlarmConfig& config) {
+	byte day, hour, minute, bits = 0;
+	bool dy, h12, pm = false;
+	rtc.getA2Time(day, hour, minute, bits, dy, h12, pm);
+	CHECK_EQ(config.day, day);
+	CHECK_EQ(config.hour, hour);
+	CHECK_EQ(config.minute, minute);
+	CHECK_EQ(config.alarmBits, bits);
+	CHECK_EQ(config.dayOfWeek, dy);
+	CHECK_EQ(config.h12, h12);
+	CHECK_EQ(config.pm, pm);
+}
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	chip.setTime(24, 6, 15, 6, 12, 34, 56);
+
+	// Both alarms, control and status in one read
+	rtc.setA1Time(5, 7, 30, 45, 0b0011, true, true, true);
+	rtc.setA2Time(31, 23, 10, 0b0010000, false, false, false);
+	rtc.turnOnAlarm(2);
+	chip.regs[0x0F] |= 0x01;
+	DS3231AlarmConfig a1, a2;
+	Wire.resetCounters();
+	CHECK(rtc.getAlarms(a1, a2));
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(Wire.counters.reads, 1);
+	checkAlarm1(rtc, a1);
+	checkAlarm2(rtc, a2);
+	CHECK_EQ(a1.hour, 7);
+	CHECK(a1.pm);
+	CHECK(!a1.enabled);
+	CHECK(a1.flag);
+	CHECK(a2.enabled);
+	CHECK(!a2.flag);
+	CHECK_EQ(a2.second, 0);
+
+	DS3231AlarmConfig one;
+	Wire.resetCounters();
+	CHECK(rtc.getAlarm(2, one));
+	CHECK_EQ(Wire.counters.reads, 1);
+	CHECK_EQ(one.day, 31);
+	CHECK_EQ(one.hour, 23);
+	CHECK(one.enabled);
+	CHECK(rtc.getAlarm(1, one));
+	CHECK_EQ(one.second, 45);
+	CHECK(one.flag);
+
+	// setAlarm() writes the same alarm registers as setA1Time() and
+	// setA2Time(), and the enable bit, in one write after one read
+	byte control = chip.regs[0x0E] | 0x20;		// CONV: not written back
+	chip.regs[0x0E] = control;
+	byte alarm2[3];
+	memcpy(alarm2, chip.regs + 0x0B, 3);
+	DS3231AlarmConfig set1 = { 12, 14, 5, 9, 0b0100, false, true, false, true, false };
+	Wire.resetCounters();
+	CHECK(rtc.setAlarm(1, set1));
+	CHECK_EQ(Wire.counters.reads, 1);
+	CHECK_EQ(Wire.counters.writes, 2);
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 1 + 8);
+	CHECK(memcmp(chip.regs + 0x0B, alarm2, 3) == 0);
+	CHECK_EQ(chip.regs[0x0E], (control & ~0x20) | 0x05);
+	byte fromSet[4];
+	memcpy(fromSet, chip.regs + 0x07, 4);
+	rtc.setA1Time(12, 14, 5, 9, 0b0100, false, true, false);
+	CHECK(memcmp(chip.regs + 0x07, fromSet, 4) == 0);
+	CHECK(rtc.getAlarm(1, one));
+	CHECK_EQ(one.hour, 2);		// 14 in 12-hour mode is 2 PM
+	CHECK(one.pm);
+	CHECK(one.enabled);
+
+	DS3231AlarmConfig set2 = { 3, 6, 45, 0, 0b1000000, true, false, false, false, false };
+	Wire.resetCounters();
+	CHECK(rtc.setAlarm(2, set2));
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 1 + 4);
+	CHECK_EQ(chip.regs[0x0E] & 0x03, 0x01);
+	CHECK(rtc.getAlarm(2, one));
+	checkAlarm2(rtc, one);
+	CHECK_EQ(one.alarmBits, 0b1000000);
+	CHECK(!one.enabled);
+
+	// Round trip of every mask and mode
+	for (byte bits = 0; bits < 0x80; bits++) {
+		DS3231AlarmConfig in = { (byte)(bits & 0x08 ? 7 : 28), (byte)(bits & 0x02 ? 11 : 19), 59, 58,
+			bits, (bool)(bits & 0x08), (bool)(bits & 0x02), (bool)(bits & 0x04), (bool)(bits & 0x10), false };
+		DS3231AlarmConfig out1, out2;
+		CHECK(rtc.setAlarm(1, in));
+		CHECK(rtc.setAlarm(2, in));
+		CHECK(rtc.getAlarms(out1, out2));
+		CHECK_EQ(out1.alarmBits, bits & 0x0F);
+		CHECK_EQ(out2.alarmBits, bits & 0x70);
+		CHECK_EQ(out1.second, 58);
+		CHECK_EQ(out1.hour, in.hour);
+		CHECK_EQ(out2.day, in.day);
+		CHECK_EQ(out2.pm, in.pm && in.h12);
+		CHECK_EQ(out1.enabled, in.enabled);
+		CHECK_EQ(out2.enabled, in.enabled);
+	}
+
+	// With the shadow on, setAlarm() is the write alone
+	rtc.setShadowMaxAge(1000);
+	CHECK(rtc.refreshShadow());
+	Wire.resetCounters();
+	CHECK(rtc.setAlarm(1, set1));
+	CHECK_EQ(Wire.counters.transactions, 1);
+	CHECK(memcmp(chip.regs + 0x07, fromSet, 4) == 0);
+	rtc.setShadowMaxAge(0);
+
+	// Bus error
+	Wire.failNext(1);
+	CHECK(!rtc.getAlarms(a1, a2));
+	Wire.failNext(1);
+	CHECK(!rtc.setAlarm(2, set2));
+
+	return checkReport("alarm_config_test");
+}
@@ -0,0 +1,146 @@
+/*
+ * async_test.cpp
+ *
+ * Steps the DS3231Async state machine one poll() at a time, first over a
+ * scripted bus that stays busy for a while, then over DS3231WireBus and
+ * the simulated DS3231.
+ */
+
+#include <DS3231Async.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+// Non-blocking bus that needs busyPolls polls per transaction, backed
+// by a MockDS3231.
+class ScriptedBus : public DS3231AsyncBus {
+	public:
+		ScriptedBus(MockDS3231& chip) : chip(chip), busyPolls(2), failRead(false),
+			remaining(0), buffer(0), count(0) {}
+		virtual bool startWrite(uint8_t, const uint8_t* data, uint8_t n) {
+			chip.onWrite(data, n);
+			remaining = busyPolls;
+			buffer = 0;
+			return true;
+		}
+		virtual bool startRead(uint8_t, uint8_t* out, uint8_t n) {
+			buffer = out;
+			count = n;
+			remaining = busyPolls;
+			return true;
+		}
+		virtual Status poll() {
+			if (remaining) {
+				remaining--;
+				return Busy;
+			}
+			if (buffer) {
+				if (failRead) return Error;
+				chip.onRead(buffer, count);
+			}
+			return Done;
+		}
+		MockDS3231& chip;
+		uint8_t busyPolls;
+		bool failRead;
+	private:
+		uint8_t remaining;
+		uint8_t* buffer;
+		uint8_t count;
+};
+
+static int callbacks = 0;
+static void onDone(DS3231Async&) { callbacks++; }
+
+int main() {
+	MockDS3231 chip;
+	chip.setTime(24, 2, 29, 4, 13, 45, 30);
+	chip.regs[0x11] = 0xE6;	// -25.75 C
+	chip.regs[0x12] = 0x40;
+
+	ScriptedBus scripted(chip);
+	DS3231Async reader(scripted);
+	reader.setCallback(onDone);
+
+	CHECK_EQ(reader.state(), DS3231Async::Idle);
+	CHECK(reader.startTimeRead());
+	CHECK(!reader.startTemperatureRead());	// one read at a time
+
+	static const DS3231Async::State expected[] = {
+		DS3231Async::AwaitPointer,
+		DS3231Async::AwaitPointer, DS3231Async::AwaitPointer,	// busy
+		DS3231Async::Receive,
+		DS3231Async::AwaitData,
+		DS3231Async::AwaitData, DS3231Async::AwaitData,		// busy
+		DS3231Async::Complete,
+		DS3231Async::Complete
+	};
+	for (unsigned i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+		CHECK_EQ(reader.poll(), expected[i]);
+	}
+	CHECK_EQ(callbacks, 1);
+	DateTime t = reader.getTime();
+	CHECK_EQ(t.year(), 2024);
+	CHECK_EQ(t.month(), 2);
+	CHECK_EQ(t.day(), 29);
+	CHECK_EQ(t.hour(), 13);
+	CHECK_EQ(t.minute(), 45);
+	CHECK_EQ(t.second(), 30);
+
+	CHECK(reader.startTemperatureRead());
+	while (reader.busy()) reader.poll();
+	CHECK_EQ(reader.state(), DS3231Async::Complete);
+	CHECK_EQ(reader.getTemperatureQuarters(), -103);
+	CHECK(reader.getTemperature() == -25.75f);
+	// Each kind of read keeps its own result
+	t = reader.getTime();
+	CHECK_EQ(t.year(), 2024);
+	CHECK_EQ(t.day(), 29);
+	CHECK_EQ(t.second(), 30);
+
+	scripted.failRead = true;
+	CHECK(reader.startStatusRead());
+	while (reader.busy()) reader.poll();
+	CHECK_EQ(reader.state(), DS3231Async::Failed);
+	CHECK_EQ(callbacks, 3);
+	CHECK_EQ(reader.getTemperatureQuarters(), -103);
+	CHECK_EQ(reader.getTime().minute(), 45);
+	scripted.failRead = false;
+	chip.regs[0x11] = 0x19;	// 25.25 C
+	chip.regs[0x12] = 0x40;
+	CHECK(reader.startTemperatureRead());
+	scripted.failRead = true;
+	while (reader.busy()) reader.poll();
+	CHECK_EQ(reader.getTemperatureQuarters(), -103);	// failed: unchanged
+	scripted.failRead = false;
+	CHECK(reader.startTemperatureRead());
+	while (reader.busy()) reader.poll();
+	CHECK_EQ(reader.getTemperatureQuarters(), 101);
+	CHECK_EQ(reader.getTime().hour(), 13);
+
+	// Over TwoWire: each poll() costs at most one bus transaction.
+	Wire.attach(&chip);
+	DS3231WireBus wireBus(Wire);
+	DS3231Async wireReader(wireBus);
+	CHECK(wireReader.startStatusRead());
+	Wire.resetCounters();
+	unsigned long steps = 0;
+	while (wireReader.busy()) {
+		unsigned long before = Wire.counters.transactions;
+		wireReader.poll();
+		CHECK(Wire.counters.transactions - before <= 1);
+		steps++;
+	}
+	CHECK_EQ(steps, 4);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(wireReader.state(), DS3231Async::Complete);
+	CHECK_EQ(wireReader.getControl(), 0b00011100);
+	CHECK_EQ(wireReader.getStatus(), 0b10001000);
+
+	// A missing device fails the read instead of hanging.
+	DS3231Async absent(wireBus, 0x57);
+	CHECK(absent.startTimeRead());
+	while (absent.busy()) absent.poll();
+	CHECK_EQ(absent.state(), DS3231Async::Failed);
+
+	return checkReport("async_test");
+}
@@ -0,0 +1,78 @@
+/*
+ * batch_bench.cpp
+ *
+ * Throughput of timestamp conversion on the host: DateTime one record at
+ * a time, the DS3231Batch array functions, and the same on all
+ * processors. Build with -O3 (and -march=native to allow the widest
+ * vectors).
+ *
+ * Output is CSV on stdout: conversion, method, million records per second.
+ */
+
+#include <chrono>
+#include <vector>
+#include <DS3231.h>
+#include <DS3231Batch.h>
+
+#define RECORDS 10000000UL
+
+static volatile uint32_t checksum;
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* conversion, const char* method, double elapsed) {
+	printf("%s,%s,%.1f\n", conversion, method, RECORDS / elapsed / 1e6);
+}
+
+int main() {
+	std::vector<uint32_t> times(RECORDS), back(RECORDS);
+	std::vector<uint16_t> year(RECORDS);
+	std::vector<uint8_t> month(RECORDS), day(RECORDS), hour(RECORDS), minute(RECORDS), second(RECORDS);
+	DS3231Batch::Fields fields = { &year[0], &month[0], &day[0], &hour[0], &minute[0], &second[0] };
+
+	// A log sampled every 7 seconds from 2024 on
+	for (size_t i = 0; i < RECORDS; i++) {
+		times[i] = 1704067200UL + 7 * i;
+	}
+
+	printf("conversion,method,mrecords_per_s\n");
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < RECORDS; i++) {
+		DateTime dt(times[i]);
+		year[i] = dt.year();
+		month[i] = dt.month();
+		day[i] = dt.day();
+		hour[i] = dt.hour();
+		minute[i] = dt.minute();
+		second[i] = dt.second();
+	}
+	report("to_fields", "DateTime", seconds(start));
+
+	start = std::chrono::steady_clock::now();
+	DS3231Batch::toFields(&times[0], fields, RECORDS);
+	report("to_fields", "batch", seconds(start));
+
+	start = std::chrono::steady_clock::now();
+	DS3231Batch::toFieldsParallel(&times[0], fields, RECORDS);
+	report("to_fields", "batch_threads", seconds(start));
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < RECORDS; i++) {
+		back[i] = DateTime(year[i], month[i], day[i], hour[i], minute[i], second[i]).unixtime();
+	}
+	report("to_unixtime", "DateTime", seconds(start));
+
+	start = std::chrono::steady_clock::now();
+	DS3231Batch::toUnixtime(fields, &back[0], RECORDS);
+	report("to_unixtime", "batch", seconds(start));
+
+	start = std::chrono::steady_clock::now();
+	DS3231Batch::toUnixtimeParallel(fields, &back[0], RECORDS);
+	report("to_unixtime", "batch_threads", seconds(start));
+
+	checksum = back[RECORDS / 2] + second[RECORDS / 3];
+	return back == times ? 0 : 1;
+}
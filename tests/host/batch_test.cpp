@@ -0,0 +1,104 @@
+/*
+ * batch_test.cpp
+ *
+ * The array conversions against DateTime: every day from 2000 to the end
+ * of the 32-bit range, serial and threaded.
+ */
+
+#include <vector>
+#include <DS3231.h>
+#include <DS3231Batch.h>
+#include "check.h"
+
+static uint32_t seed = 7;
+
+static uint32_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 4;
+}
+
+struct FieldArrays {
+	FieldArrays(size_t n) : year(n), month(n), day(n), hour(n), minute(n), second(n) {
+		DS3231Batch::Fields f = { &year[0], &month[0], &day[0], &hour[0], &minute[0], &second[0] };
+		fields = f;
+	}
+	std::vector<uint16_t> year;
+	std::vector<uint8_t> month, day, hour, minute, second;
+	DS3231Batch::Fields fields;
+};
+
+static size_t mismatches(const FieldArrays& a, const uint32_t* times, size_t n) {
+	size_t bad = 0;
+	for (size_t i = 0; i < n; i++) {
+		DateTime dt(times[i]);
+		bad += a.year[i] != dt.year() || a.month[i] != dt.month() || a.day[i] != dt.day()
+			|| a.hour[i] != dt.hour() || a.minute[i] != dt.minute() || a.second[i] != dt.second();
+	}
+	return bad;
+}
+
+int main() {
+	// Unix time to fields: first and last second and a random second of
+	// every day through 2106-02-07, the end of the 32-bit range
+	std::vector<uint32_t> times;
+	for (uint32_t day = 946684800UL / 86400; day <= 0xFFFFFFFFUL / 86400; day++) {
+		uint32_t midnight = day * 86400UL;
+		times.push_back(midnight);
+		if (0xFFFFFFFFUL - midnight >= 86399UL) {
+			times.push_back(midnight + 86399UL);
+			times.push_back(midnight + nextRandom() % 86400UL);
+		}
+	}
+	times.push_back(0xFFFFFFFFUL);
+	FieldArrays fields(times.size());
+	DS3231Batch::toFields(&times[0], fields.fields, times.size());
+	CHECK_EQ(mismatches(fields, &times[0], times.size()), 0);
+
+	// Fields to Unix time for every day of 2000-2099, which comes back
+	// unchanged; whole years as DateTime takes them, offsets as well
+	std::vector<uint32_t> inRange, back(times.size());
+	for (size_t i = 0; i < times.size() && times[i] < 4102444800UL; i++) {
+		inRange.push_back(times[i]);
+	}
+	DS3231Batch::toUnixtime(fields.fields, &back[0], inRange.size());
+	for (size_t i = 0; i < inRange.size(); i++) {
+		if (back[i] != inRange[i]) {
+			CHECK_EQ(back[i], inRange[i]);
+			break;
+		}
+	}
+	FieldArrays offsets(1000);
+	std::vector<uint32_t> fromOffsets(1000);
+	for (size_t i = 0; i < 1000; i++) {
+		offsets.year[i] = i % 2 ? nextRandom() % 100 : 2000 + nextRandom() % 100;
+		offsets.month[i] = 1 + nextRandom() % 12;
+		offsets.day[i] = 1 + nextRandom() % 28;
+		offsets.hour[i] = nextRandom() % 24;
+		offsets.minute[i] = nextRandom() % 60;
+		offsets.second[i] = nextRandom() % 60;
+	}
+	DS3231Batch::toUnixtime(offsets.fields, &fromOffsets[0], 1000);
+	for (size_t i = 0; i < 1000; i++) {
+		CHECK_EQ(fromOffsets[i], DateTime(offsets.year[i], offsets.month[i], offsets.day[i],
+			offsets.hour[i], offsets.minute[i], offsets.second[i]).unixtime());
+	}
+
+	// Threads give the same results, for any length and thread count
+	const size_t counts[] = { 0, 1, 16383, 100001, times.size() };
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		size_t n = counts[c];
+		for (unsigned threads = 0; threads <= 5; threads++) {
+			FieldArrays parallel(n + 1);
+			std::vector<uint32_t> roundTrip(n + 1, 0), serial(n + 1, 0);
+			parallel.second[n] = 0xEE;
+			DS3231Batch::toFieldsParallel(&times[0], parallel.fields, n, threads);
+			CHECK_EQ(mismatches(parallel, &times[0], n), 0);
+			CHECK_EQ(parallel.second[n], 0xEE);
+			DS3231Batch::toUnixtimeParallel(parallel.fields, &roundTrip[0], n, threads);
+			DS3231Batch::toUnixtime(parallel.fields, &serial[0], n);
+			CHECK(roundTrip == serial);
+		}
+	}
+
+	return checkReport("batch_test");
+}
@@ -0,0 +1,82 @@
+/*
+ * bcd_bench.cpp
+ *
+ * Host timing of the BCD conversion of a 7-byte time block: the original
+ * divide and modulo formulas one field at a time, the word-wide kernels
+ * and the byte-wise kernels used on AVR. Host timings only show the
+ * relative cost of the operations; the AVR table exists because the AVR
+ * has no divide instruction.
+ *
+ * Output is CSV on stdout: kernel, nanoseconds per block.
+ */
+
+#include <chrono>
+#include <DS3231.h>
+
+#define BLOCKS 2000000UL
+
+static uint8_t referenceToDec(uint8_t v) { return v / 16 * 10 + v % 16; }
+static uint8_t referenceToBcd(uint8_t v) { return v / 10 * 16 + v % 10; }
+
+static void swarDecode(const uint8_t* in, uint8_t* out) {
+	uint64_t word = DS3231BCD::decodeLanes(DS3231BCD::pack8(in, 7));
+	for (uint8_t i = 0; i < 7; i++) out[i] = (uint8_t)(word >> (8 * i));
+}
+
+static void swarEncode(const uint8_t* in, uint8_t* out) {
+	uint64_t low = DS3231BCD::encodeLanes(DS3231BCD::pack16(in, 4));
+	uint64_t high = DS3231BCD::encodeLanes(DS3231BCD::pack16(in + 4, 3));
+	for (uint8_t i = 0; i < 4; i++) out[i] = (uint8_t)(low >> (16 * i));
+	for (uint8_t i = 0; i < 3; i++) out[4 + i] = (uint8_t)(high >> (16 * i));
+}
+
+static void tableEncode(const uint8_t* in, uint8_t* out) {
+	for (uint8_t i = 0; i < 7; i++) out[i] = pgm_read_byte(&DS3231BCDTable[in[i]]);
+}
+
+static void shiftDecode(const uint8_t* in, uint8_t* out) {
+	for (uint8_t i = 0; i < 7; i++) out[i] = DS3231BCD::toDec(in[i]);
+}
+
+static void referenceDecode(const uint8_t* in, uint8_t* out) {
+	for (uint8_t i = 0; i < 7; i++) out[i] = referenceToDec(in[i]);
+}
+
+static void referenceEncode(const uint8_t* in, uint8_t* out) {
+	for (uint8_t i = 0; i < 7; i++) out[i] = referenceToBcd(in[i]);
+}
+
+// Runs kernel over a rotating set of blocks and returns ns per block.
+// The checksum keeps the compiler from dropping the work.
+static volatile uint32_t checksum;
+
+static double run(void (*kernel)(const uint8_t*, uint8_t*), bool encode) {
+	static uint8_t blocks[64][7];
+	uint8_t out[7];
+	uint32_t sum = 0;
+	for (uint8_t b = 0; b < 64; b++) {
+		for (uint8_t i = 0; i < 7; i++) {
+			uint8_t dec = (b * 7 + i * 13) % 60;
+			blocks[b][i] = encode ? dec : referenceToBcd(dec);
+		}
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned long n = 0; n < BLOCKS; n++) {
+		kernel(blocks[n & 63], out);
+		sum += out[n % 7];
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	checksum = sum;
+	return std::chrono::duration<double, std::nano>(end - start).count() / BLOCKS;
+}
+
+int main() {
+	printf("kernel,ns_per_block\n");
+	printf("decode:divide-modulo,%.2f\n", run(referenceDecode, false));
+	printf("decode:shift-multiply,%.2f\n", run(shiftDecode, false));
+	printf("decode:swar,%.2f\n", run(swarDecode, false));
+	printf("encode:divide-modulo,%.2f\n", run(referenceEncode, true));
+	printf("encode:table,%.2f\n", run(tableEncode, true));
+	printf("encode:swar,%.2f\n", run(swarEncode, true));
+	return 0;
+}
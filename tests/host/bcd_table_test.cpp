@@ -0,0 +1,9 @@
+/*
+ * bcd_table_test.cpp
+ *
+ * bcd_test.cpp again, with the one-byte-at-a-time kernels used on AVR.
+ *
+ * host-test-flags: -DDS3231_BCD_SWAR=0
+ */
+
+#include "bcd_test.cpp"
@@ -0,0 +1,110 @@
+/*
+ * bcd_test.cpp
+ *
+ * Exhaustive comparison of the BCD kernels, word-wide and table-driven,
+ * with the original divide and modulo formulas.
+ */
+
+#include <DS3231.h>
+#include <DS3231Driver.h>
+#include "check.h"
+
+static uint8_t referenceToDec(uint8_t v) { return v / 16 * 10 + v % 16; }
+static uint8_t referenceToBcd(uint8_t v) { return v / 10 * 16 + v % 10; }
+
+static uint32_t seed = 1;
+
+static uint8_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 16;
+}
+
+int main() {
+	// One value at a time, for every byte
+	for (unsigned v = 0; v < 256; v++) {
+		CHECK_EQ(DS3231BCD::toDec(v), referenceToDec(v));
+		CHECK_EQ(DS3231BCD::toBcd(v), referenceToBcd(v));
+		CHECK_EQ(DS3231BCD::decode(v), referenceToDec(v));
+		CHECK_EQ(DS3231BCD::encode(v), referenceToBcd(v));
+	}
+	for (unsigned v = 0; v < 100; v++) {
+		CHECK_EQ(pgm_read_byte(&DS3231BCDTable[v]), referenceToBcd(v));
+	}
+
+	// Every byte value in every lane, beside random neighbours
+	for (unsigned lane = 0; lane < 8; lane++) {
+		for (unsigned v = 0; v < 256; v++) {
+			uint8_t in[8], out[8];
+			for (uint8_t i = 0; i < 8; i++) in[i] = nextRandom();
+			in[lane] = v;
+			uint64_t word = DS3231BCD::decodeLanes(DS3231BCD::pack8(in, 8));
+			for (uint8_t i = 0; i < 8; i++) {
+				CHECK_EQ((uint8_t)(word >> (8 * i)), referenceToDec(in[i]));
+			}
+			DS3231BCD::decodeBlock(in, out, 8);
+			for (uint8_t i = 0; i < 8; i++) {
+				CHECK_EQ(out[i], referenceToDec(in[i]));
+			}
+		}
+	}
+	for (unsigned lane = 0; lane < 4; lane++) {
+		for (unsigned v = 0; v < 100; v++) {
+			uint8_t in[4], out[4];
+			for (uint8_t i = 0; i < 4; i++) in[i] = nextRandom() % 100;
+			in[lane] = v;
+			uint64_t word = DS3231BCD::encodeLanes(DS3231BCD::pack16(in, 4));
+			for (uint8_t i = 0; i < 4; i++) {
+				CHECK_EQ((uint8_t)(word >> (16 * i)), referenceToBcd(in[i]));
+				CHECK_EQ((uint16_t)(word >> (16 * i)), referenceToBcd(in[i]));
+			}
+			DS3231BCD::encodeBlock(in, out, 4);
+			for (uint8_t i = 0; i < 4; i++) {
+				CHECK_EQ(out[i], referenceToBcd(in[i]));
+			}
+		}
+	}
+
+	// Blocks of every length up to 20, converted in place and back
+	for (uint8_t count = 0; count <= 20; count++) {
+		uint8_t dec[21], bcd[21];
+		for (uint8_t i = 0; i <= 20; i++) dec[i] = nextRandom() % 100;
+		memcpy(bcd, dec, sizeof(bcd));
+		DS3231BCD::encodeBlock(bcd, bcd, count);
+		for (uint8_t i = 0; i < count; i++) {
+			CHECK_EQ(bcd[i], referenceToBcd(dec[i]));
+		}
+		CHECK_EQ(bcd[count], dec[count]);	// nothing beyond count
+		DS3231BCD::decodeBlock(bcd, bcd, count);
+		CHECK(memcmp(bcd, dec, sizeof(dec)) == 0);
+	}
+
+	// Time registers: every value of every register, flag bits included
+	for (unsigned reg = 0; reg < 7; reg++) {
+		for (unsigned v = 0; v < 256; v++) {
+			uint8_t regs[7];
+			for (uint8_t i = 0; i < 7; i++) regs[i] = nextRandom();
+			regs[reg] = v;
+			DateTime t = DS3231Registers::decodeTime(regs);
+			CHECK_EQ(t.second(), referenceToDec(regs[0] & 0x7F));
+			CHECK_EQ(t.minute(), referenceToDec(regs[1] & 0x7F));
+			CHECK_EQ(t.hour(), referenceToDec(regs[2] & 0x3F));
+			CHECK_EQ(t.day(), referenceToDec(regs[4] & 0x3F));
+			CHECK_EQ(t.month(), referenceToDec(regs[5] & 0x1F));
+			CHECK_EQ(t.year(), 2000 + referenceToDec(regs[6]));
+		}
+	}
+
+	// Times all through 2024, through encodeTime() and back
+	for (uint32_t t = 1704067200UL; t < 1735689600UL; t += 1 + nextRandom() % 60) {
+		DateTime dt(t);
+		uint8_t regs[7];
+		DS3231Registers::encodeTime(dt, regs);
+		CHECK_EQ(regs[0], referenceToBcd(dt.second()));
+		CHECK_EQ(regs[2], referenceToBcd(dt.hour()));
+		CHECK_EQ(regs[3], dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek());
+		CHECK_EQ(regs[6], 0x24);
+		CHECK_EQ(DS3231Registers::decodeTime(regs).unixtime(), t);
+	}
+
+	return checkReport(DS3231_BCD_SWAR ? "bcd_test (SWAR)" : "bcd_test (table)");
+}
@@ -0,0 +1,76 @@
+/*
+ * build_time_test.cpp
+ *
+ * DS3231_BUILD_TIME and DS3231BuildTime are evaluated by the compiler;
+ * the run-time DateTime(date, time) parser must still agree with the
+ * sscanf-based code it replaces.
+ */
+
+#include <DS3231.h>
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+
+// Compile-time checks: these fail the build, not the test.
+static_assert(DS3231BuildTime::unixtime("Jan  1 2000", "00:00:00") == 946684800UL, "epoch 2000");
+static_assert(DS3231BuildTime::unixtime("Feb 29 2024", "13:45:30") == 1709214330UL, "leap day");
+static_assert(DS3231BuildTime::unixtime("Dec 31 2099", "23:59:59") == 4102444799UL, "end of range");
+static_assert(DS3231BuildTime::dateTime("Sep  7 2022", "08:05:09").day() == 7, "padded day");
+static_assert(DS3231BuildTime::month("Jun 1 2022") == 6 && DS3231BuildTime::month("Jul 1 2022") == 7, "Jun/Jul");
+static_assert(DS3231BuildTime::month("Mar 1 2022") == 3 && DS3231BuildTime::month("May 1 2022") == 5, "Mar/May");
+static_assert(DS3231BuildTime::month("Apr 1 2022") == 4 && DS3231BuildTime::month("Aug 1 2022") == 8, "Apr/Aug");
+static_assert(DS3231_BUILD_TIME.year() >= 2024, "build year");
+
+constexpr DateTime built = DS3231_BUILD_TIME;
+constexpr uint32_t builtUnix = DS3231_BUILD_UNIXTIME;
+
+// The implementation the run-time parser replaces, as of v1.2.0
+static void refParse(const char* date, const char* time, uint8_t* f) {
+	static const char month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	static char buff[4] = {'0','0','0','0'};
+	int y;
+	sscanf(date, "%s %hhu %d", buff, &f[2], &y);
+	f[0] = y >= 2000 ? y - 2000 : y;
+	f[1] = (strstr(month_names, buff) - month_names) / 3 + 1;
+	sscanf(time, "%hhu:%hhu:%hhu", &f[3], &f[4], &f[5]);
+}
+
+int main() {
+	static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+		"Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	char date[16], time[16];
+	uint8_t f[6];
+
+	CHECK_EQ(built.unixtime(), builtUnix);
+	CHECK_EQ(DateTime(__DATE__, __TIME__).unixtime(), builtUnix);
+
+	// Every day of the DS3231's century, at a few times of day
+	for (int y = 2000; y <= 2099; y++) {
+		for (int m = 0; m < 12; m++) {
+			for (int d = 1; d <= 31; d++) {
+				snprintf(date, sizeof(date), "%s %2d %d", months[m], d, y);
+				snprintf(time, sizeof(time), "%02d:%02d:%02d", d % 24, (d * 7) % 60, (y + d) % 60);
+				refParse(date, time, f);
+				DateTime dt(date, time);
+				CHECK_EQ(dt.year() - 2000, f[0]);
+				CHECK_EQ(dt.month(), f[1]);
+				CHECK_EQ(dt.day(), f[2]);
+				CHECK_EQ(dt.hour(), f[3]);
+				CHECK_EQ(dt.minute(), f[4]);
+				CHECK_EQ(dt.second(), f[5]);
+				if (d <= 28) {
+					CHECK_EQ(DS3231BuildTime::unixtime(date, time), dt.unixtime());
+				}
+			}
+		}
+	}
+
+	// Unpadded days are accepted at run time, as sscanf did.
+	DateTime loose("Mar 5 2023", "7:08:09");
+	CHECK_EQ(loose.day(), 5);
+	CHECK_EQ(loose.year(), 2023);
+	CHECK_EQ(loose.hour(), 7);
+	CHECK_EQ(loose.second(), 9);
+
+	return checkReport("build_time_test");
+}
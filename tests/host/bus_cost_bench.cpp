@@ -0,0 +1,136 @@
+/*
+ * bus_cost_bench.cpp
+ *
+ * Reports what each public DS3231 call costs on the I2C bus: transactions,
+ * payload bytes each way, and the estimated bus time at 100 kHz and
+ * 400 kHz (START, address, ACK bits and STOP included, clock stretching
+ * and software overhead not).
+ *
+ * Output is CSV on stdout, one line per call, so successive runs can be
+ * diffed or tracked by a script.
+ */
+
+#include <DS3231.h>
+#include <DS3231Driver.h>
+#include <DS3231Events.h>
+#include "MockDS3231.h"
+
+static void report(const char* api) {
+	const MockBusCounters& c = Wire.counters;
+	printf("%s,%lu,%lu,%lu,%lu,%lu,%.1f,%.1f\n", api,
+		c.transactions, c.writes, c.reads, c.bytesWritten, c.bytesRead,
+		c.bitTimes * 1e6 / 100000.0, c.bitTimes * 1e6 / 400000.0);
+}
+
+#define MEASURE(api, call) do { \
+	Wire.resetCounters(); \
+	call; \
+	report(api); \
+} while (0)
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	chip.setTime(24, 6, 15, 6, 12, 30, 0);
+
+	bool h12, pm, century, dy;
+	byte day, hour, minute, second, bits = 0;
+	int16_t quarters;
+	int8_t offset;
+	bits3231 image;
+	DS3231AlarmConfig alarm1, alarm2;
+	uint32_t queue[4];
+	DS3231Events events(rtc, queue, 4);
+	DateTime upcoming[3];
+	DateTime dt;
+	DS3231Driver<TwoWire> driver(Wire);
+
+	printf("api,transactions,writes,reads,bytes_written,bytes_read,us_100khz,us_400khz\n");
+
+	// Time retrieval
+	MEASURE("getSecond", rtc.getSecond());
+	MEASURE("getMinute", rtc.getMinute());
+	MEASURE("getHour", rtc.getHour(h12, pm));
+	MEASURE("getDoW", rtc.getDoW());
+	MEASURE("getDate", rtc.getDate());
+	MEASURE("getMonth", rtc.getMonth(century));
+	MEASURE("getYear", rtc.getYear());
+	MEASURE("RTClib::now", RTClib::now());
+	MEASURE("now", rtc.now(dt));
+
+	// Time setting
+	MEASURE("setSecond", rtc.setSecond(0));
+	MEASURE("setMinute", rtc.setMinute(30));
+	MEASURE("setHour", rtc.setHour(12));
+	MEASURE("setDoW", rtc.setDoW(6));
+	MEASURE("setDate", rtc.setDate(15));
+	MEASURE("setMonth", rtc.setMonth(6));
+	MEASURE("setYear", rtc.setYear(24));
+	MEASURE("setClockMode", rtc.setClockMode(false));
+	MEASURE("setEpoch", rtc.setEpoch(1718454600UL));
+	MEASURE("setDateTime", rtc.setDateTime(24, 6, 15, 6, 12, 30, 0));
+	MEASURE("setDateTime(HourField)", rtc.setDateTime(0, 0, 0, 0, 12, 0, 0, DS3231::HourField));
+	MEASURE("adjust", rtc.adjust(DateTime(2024, 6, 15, 12, 30, 0)));
+
+	// Temperature
+	MEASURE("getTemperature", rtc.getTemperature());
+	MEASURE("getTemperatureQuarters", rtc.getTemperatureQuarters(quarters));
+	MEASURE("startTemperatureConversion", rtc.startTemperatureConversion());
+	MEASURE("pollTemperatureConversion", rtc.pollTemperatureConversion(quarters));
+
+	// Alarms
+	MEASURE("getA1Time", rtc.getA1Time(day, hour, minute, second, bits, dy, h12, pm));
+	MEASURE("getA2Time", rtc.getA2Time(day, hour, minute, bits, dy, h12, pm));
+	MEASURE("setA1Time", rtc.setA1Time(0, 12, 31, 0, 0b00001000, false, false, false));
+	MEASURE("setA2Time", rtc.setA2Time(0, 12, 32, 0b01000000, false, false, false));
+	MEASURE("setAlarm1Simple", rtc.setAlarm1Simple(12, 31));
+	MEASURE("setAlarm2Simple", rtc.setAlarm2Simple(12, 32));
+	MEASURE("turnOnAlarm", rtc.turnOnAlarm(1));
+	MEASURE("turnOffAlarm", rtc.turnOffAlarm(1));
+	MEASURE("checkAlarmEnabled", rtc.checkAlarmEnabled(1));
+	MEASURE("checkIfAlarm", rtc.checkIfAlarm(1));
+	MEASURE("checkIfAlarm(noclear)", rtc.checkIfAlarm(1, false));
+	MEASURE("getNextAlarms", rtc.getNextAlarms(1, upcoming, 3));
+	MEASURE("getAlarms", rtc.getAlarms(alarm1, alarm2));
+	MEASURE("getAlarm", rtc.getAlarm(1, alarm1));
+	MEASURE("setAlarm", rtc.setAlarm(1, alarm1));
+	MEASURE("checkAlarms", rtc.checkAlarms());
+	MEASURE("checkAlarms(noclear)", rtc.checkAlarms(false, false));
+
+	// Alarm events: an empty queue, then one interrupt for a fired alarm
+	MEASURE("DS3231Events::service(idle)", events.service());
+	rtc.turnOnAlarm(1);
+	chip.regs[0x0F] |= 0x01;
+	events.onInterrupt();
+	MEASURE("DS3231Events::service", events.service());
+
+	// Oscillator
+	MEASURE("enableOscillator", rtc.enableOscillator(true, false, 0));
+	MEASURE("enable32kHz", rtc.enable32kHz(true));
+	MEASURE("oscillatorCheck", rtc.oscillatorCheck());
+	MEASURE("getAgingOffset", rtc.getAgingOffset(offset));
+	MEASURE("setAgingOffset", rtc.setAgingOffset(0));
+
+	// Register image: a read, a restore that finds nothing to do, and one
+	// that rewrites the aging offset
+	MEASURE("readImage", rtc.readImage(image));
+	MEASURE("applyImage", rtc.applyImage(image));
+	chip.regs[0x10] = 5;
+	MEASURE("applyImage(one register)", rtc.applyImage(image));
+
+	// Compile-time driver
+	MEASURE("DS3231Driver::now", driver.now(dt));
+	MEASURE("DS3231Driver::adjust", driver.adjust(dt));
+	MEASURE("DS3231Driver::getTemperatureQuarters", driver.getTemperatureQuarters(quarters));
+	MEASURE("DS3231Driver::checkIfAlarm", driver.checkIfAlarm(1));
+
+	// Register shadow: a refresh, then a full timestamp from the copy
+	rtc.setShadowMaxAge(1000);
+	MEASURE("refreshShadow", rtc.refreshShadow());
+	MEASURE("shadow:getSecond..getYear", (rtc.getSecond(), rtc.getMinute(),
+		rtc.getHour(h12, pm), rtc.getDate(), rtc.getMonth(century), rtc.getYear()));
+	MEASURE("shadow:setEpoch", rtc.setEpoch(1718454600UL));
+
+	return 0;
+}
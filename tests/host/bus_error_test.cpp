@@ -0,0 +1,183 @@
+/*
+ * bus_error_test.cpp
+ *
+ * Status codes of failed register accesses, retries, the per-access
+ * budget, the Wire timeout and bus recovery, against a mock bus that can
+ * fail, hang or have SDA held low.
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "MockMux.h"
+#include "check.h"
+
+#define SCL_PIN 5
+#define SDA_PIN 4
+
+int main() {
+	MockDS3231 chip;
+	MockMux mux;
+	MockDS3231 behindMux;
+	Wire.attach(&chip);
+	Wire.attach(&mux);
+	mux.attach(2, &behindMux);
+	chip.setTime(24, 6, 15, 6, 12, 0, 0);
+	behindMux.setTime(24, 6, 15, 6, 12, 0, 0);
+
+	DS3231 rtc;
+	DateTime dt;
+
+	// The default: one attempt, and the reason for a failure
+	CHECK(rtc.now(dt));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusOk);
+	Wire.resetCounters();
+	Wire.failNext(1);
+	CHECK(!rtc.now(dt));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusError);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK(rtc.now(dt));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusOk);
+
+	DS3231 missing(Wire, 0x50);
+	CHECK(!missing.now(dt));
+	CHECK_EQ(missing.getLastError(), DS3231::BusNack);
+	missing.setSecond(5);
+	CHECK_EQ(missing.getLastError(), DS3231::BusNack);
+
+	// Retries: recovered within the count, or given up after it
+	rtc.setBusTimeout(0, 2);
+	Wire.failNext(2);
+	CHECK(rtc.now(dt));
+	CHECK_EQ(dt.hour(), 12);
+	Wire.resetCounters();
+	Wire.failNext(10);
+	CHECK(!rtc.now(dt));
+	CHECK_EQ(Wire.counters.transactions, 6);
+	Wire.failNext(0);
+	Wire.failNext(1);
+	rtc.setSecond(30);
+	CHECK_EQ(rtc.getLastError(), DS3231::BusOk);
+	CHECK_EQ(chip.regs[0], 0x30);
+
+	// A NACK is retried as well
+	missing.setBusTimeout(0, 3);
+	Wire.resetCounters();
+	CHECK(!missing.now(dt));
+	CHECK_EQ(Wire.counters.transactions, 8);
+
+	// The Wire timeout, and the budget bounding a hung bus
+	rtc.setBusTimeout(1000, 0);
+	CHECK_EQ(Wire.wireTimeout, 1000);
+	CHECK(Wire.wireTimeoutReset);
+	Wire.hangNext(1);
+	CHECK(!rtc.now(dt));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusTimeout);
+	CHECK(!Wire.getWireTimeoutFlag());
+	Wire.hangNext(1);
+	rtc.adjust(DateTime(2024, 6, 15, 12, 0, 0));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusTimeout);
+
+	rtc.setBusTimeout(1000, 50, 2500);
+	Wire.hangNext(1000);
+	unsigned long start = micros();
+	CHECK(!rtc.now(dt));
+	unsigned long elapsed = micros() - start;
+	CHECK(elapsed >= 2500);
+	CHECK(elapsed <= 2500 + 2 * 1000);
+	CHECK_EQ(rtc.getLastError(), DS3231::BusTimeout);
+	Wire.hangNext(0);
+	CHECK(rtc.now(dt));
+
+	// Bus recovery before a retry: a released SDA just gets a STOP
+	rtc.setBusTimeout(0, 1);
+	rtc.setBusRecovery(SCL_PIN, SDA_PIN, 400000UL);
+	unsigned long begins = Wire.beginCount;
+	unsigned long sclPulses = mockPulses(SCL_PIN);
+	Wire.failNext(1);
+	CHECK(rtc.now(dt));
+	CHECK_EQ(Wire.beginCount, begins + 1);
+	CHECK_EQ(Wire.clockHz, 400000UL);
+	CHECK_EQ(mockPulses(SCL_PIN), sclPulses);
+	CHECK_EQ(mockPulses(SDA_PIN), 1);
+
+	// ... a device holding SDA gets nine clocks, then the bus is stuck
+	mockHoldLow(SDA_PIN, true);
+	Wire.resetCounters();
+	Wire.failNext(1);
+	CHECK(!rtc.now(dt));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusStuck);
+	CHECK_EQ(mockPulses(SCL_PIN), sclPulses + 9);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	mockHoldLow(SDA_PIN, false);
+
+	// ... and a NACK needs no recovery
+	missing.setBusRecovery(SCL_PIN, SDA_PIN);
+	begins = Wire.beginCount;
+	CHECK(!missing.now(dt));
+	CHECK_EQ(Wire.beginCount, begins);
+
+	// A failed mux selection is retried with the channel selected again
+	DS3231 muxed(Wire, 0x68, 0x70, 2);
+	muxed.setBusTimeout(0, 1);
+	CHECK(muxed.now(dt));
+	DS3231::forgetMuxSelection();
+	unsigned long selections = mux.selections;
+	Wire.failNext(1);
+	CHECK(muxed.now(dt));
+	CHECK_EQ(mux.selections, selections + 1);
+	CHECK_EQ(muxed.getLastError(), DS3231::BusOk);
+
+	// A setter whose read fails writes nothing back and keeps the error
+	DS3231 plain;
+	CHECK(plain.now(dt));	// closes the mux channel left open above
+	byte control = chip.regs[0x0E] = 0b00011101;
+	Wire.failNext(1);
+	plain.turnOffAlarm(1);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x0E], control);
+	Wire.failNext(1);
+	plain.turnOnAlarm(2);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x0E], control);
+	Wire.failNext(1);
+	plain.enableOscillator(false, false, 0);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x0E], control);
+
+	chip.regs[0x0F] = 0b10000001;	// OSF, A1F
+	Wire.resetCounters();
+	Wire.failNext(1);
+	plain.enable32kHz(true);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(Wire.counters.writes, 1);
+	CHECK_EQ(chip.regs[0x0F], 0b10000001);
+	Wire.failNext(1);
+	CHECK(!plain.checkIfAlarm(1));
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x0F], 0b10000001);
+	Wire.failNext(1, 1);
+	plain.setSecond(10);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x00], 0x10);
+	CHECK_EQ(chip.regs[0x0F], 0b10000001);
+
+	byte hour = chip.regs[0x02];
+	Wire.failNext(1);
+	plain.setClockMode(true);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x02], hour);
+	Wire.failNext(1);
+	plain.setHour(7);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x02], hour);
+
+	// ... and getNextAlarms() gives up when the alarm cannot be read
+	DateTime upcoming[2];
+	plain.setAlarm1Simple(12, 31);
+	CHECK_EQ(plain.getNextAlarms(1, upcoming, 2), 2);
+	Wire.failNext(1, 2);
+	CHECK_EQ(plain.getNextAlarms(1, upcoming, 2), 0);
+	CHECK_EQ(plain.getLastError(), DS3231::BusError);
+
+	return checkReport("bus_error_test");
+}
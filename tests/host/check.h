@@ -0,0 +1,36 @@
+/*
+ * check.h
+ *
+ * Tiny assertion helpers shared by the host tests. Each test binary
+ * returns non-zero if any CHECK failed.
+ */
+
+#ifndef DS3231_HOST_CHECK_h
+#define DS3231_HOST_CHECK_h
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		checkFailures++; \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+	} \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+	long long check_a = (long long)(a), check_b = (long long)(b); \
+	if (check_a != check_b) { \
+		checkFailures++; \
+		printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+			__FILE__, __LINE__, #a, #b, check_a, check_b); \
+	} \
+} while (0)
+
+static inline int checkReport(const char* name) {
+	printf("%s: %s\n", name, checkFailures ? "FAILED" : "passed");
+	return checkFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * conversion_test.cpp
+ *
+ * The constant-time DateTime(uint32_t) and date2days() must agree with
+ * the original loop-based code. Every day a 32-bit unixtime can reach
+ * (including values before 2000, which wrap) is checked, at the seconds
+ * where the time-of-day fields roll over.
+ */
+
+#include <DS3231.h>
+#include "check.h"
+
+// The implementation these replace, as of v1.2.0
+static const uint8_t refDaysInMonth[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+
+static uint16_t refDate2days(uint16_t y, uint8_t m, uint8_t d) {
+	if (y >= 2000)
+		y -= 2000;
+	uint16_t days = d;
+	for (uint8_t i = 1; i < m; ++i)
+		days += refDaysInMonth[i - 1];
+	if (m > 2 && isleapYear(y))
+		++days;
+	return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+static void refFromUnix(uint32_t t, uint8_t* f) {
+	t -= 946684800UL;
+	f[5] = t % 60; t /= 60;
+	f[4] = t % 60; t /= 60;
+	f[3] = t % 24;
+	uint16_t days = t / 24;
+	uint8_t leap, yOff, m;
+	for (yOff = 0; ; ++yOff) {
+		leap = isleapYear((uint16_t) yOff);
+		if (days < (uint16_t)(365 + leap))
+			break;
+		days -= (365 + leap);
+	}
+	for (m = 1; ; ++m) {
+		uint8_t daysPerMonth = refDaysInMonth[m - 1];
+		if (leap && m == 2)
+			++daysPerMonth;
+		if (days < daysPerMonth)
+			break;
+		days -= daysPerMonth;
+	}
+	f[0] = yOff; f[1] = m; f[2] = days + 1;
+}
+
+static uint32_t refUnixtime(uint8_t yOff, uint8_t m, uint8_t d, uint8_t hh, uint8_t mm, uint8_t ss) {
+	uint16_t days = refDate2days(yOff, m, d);
+	uint32_t t = ((days * 24L + hh) * 60 + mm) * 60 + ss;
+	return t + 946684800UL;
+}
+
+int main() {
+	static const uint32_t offsets[] = { 0, 1, 59, 60, 3599, 3600, 43200, 86399 };
+	unsigned long mismatches = 0;
+
+	for (uint32_t day = 0; day <= 0xFFFFFFFFUL / 86400UL; day++) {
+		for (unsigned i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+			uint32_t t = 946684800UL + day * 86400UL + offsets[i];
+			uint8_t f[6];
+			refFromUnix(t, f);
+			DateTime dt(t);
+			if (dt.year() != 2000 + f[0] || dt.month() != f[1] || dt.day() != f[2]
+					|| dt.hour() != f[3] || dt.minute() != f[4] || dt.second() != f[5]) {
+				if (mismatches++ < 5) printf("DateTime(%lu) differs\n", (unsigned long)t);
+			}
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+
+	// date2days through unixtime() and dayOfTheWeek(), for every field
+	// combination including out-of-range days and month 0.
+	mismatches = 0;
+	for (uint16_t y = 0; y < 256; y++) {
+		for (uint8_t m = 0; m <= 12; m++) {
+			for (uint8_t d = 0; d <= 31; d++) {
+				DateTime dt(y, m, d, 23, 59, 59);
+				uint32_t expected = refUnixtime(y, m, d, 23, 59, 59);
+				uint8_t expectedDow = (refDate2days(y, m, d) + 6) % 7;
+				if (dt.unixtime() != expected || dt.dayOfTheWeek() != expectedDow) {
+					if (mismatches++ < 5) printf("date2days(%u, %u, %u) differs\n", y, m, d);
+				}
+			}
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+	CHECK_EQ(DateTime(24, 13, 1, 0, 0, 0).unixtime(), DateTime(24, 12, 1, 0, 0, 0).unixtime());
+	CHECK_EQ(DateTime(24, 255, 1, 0, 0, 0).unixtime(), DateTime(24, 12, 1, 0, 0, 0).unixtime());
+
+	// Round trip over the DS3231 range
+	for (uint32_t t = 946684800UL; t < 4102444800UL; t += 9973UL) {
+		CHECK_EQ(DateTime(t).unixtime(), t);
+	}
+
+	return checkReport("conversion_test");
+}
@@ -0,0 +1,162 @@
+/*
+ * driver_test.cpp
+ *
+ * DS3231Driver on the simulated TwoWire and on a bus class of its own,
+ * compared with the DS3231 class; compile-time register decoding.
+ */
+
+#include <DS3231.h>
+#include <DS3231Driver.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+// A bus that is not a TwoWire: a bare register file answering at 0x68,
+// with just the functions DS3231Driver calls.
+class RegisterFileBus {
+	public:
+		RegisterFileBus() : pointer(0), length(0), index(0), calls(0) {
+			memset(regs, 0, sizeof(regs));
+		}
+		void beginTransmission(uint8_t address) { target = address; first = true; calls++; }
+		size_t write(uint8_t data) {
+			if (first) pointer = data;
+			else regs[pointer++ % sizeof(regs)] = data;
+			first = false;
+			return 1;
+		}
+		uint8_t endTransmission() { return target == 0x68 ? 0 : 2; }
+		uint8_t requestFrom(int address, int quantity) {
+			calls++;
+			index = 0;
+			length = address == 0x68 ? quantity : 0;
+			return length;
+		}
+		int read() { return index < length ? regs[(pointer + index++) % sizeof(regs)] : -1; }
+
+		uint8_t regs[0x13];
+		uint8_t pointer, length, index;
+		uint8_t target;
+		bool first;
+		unsigned calls;
+};
+
+// Sets more status flags after the next read, as if an alarm fired
+// between a read and the write that follows it.
+class RacingDS3231 : public MockDS3231 {
+	public:
+		RacingDS3231() : raise(0) {}
+		virtual size_t onRead(uint8_t* out, size_t n) {
+			size_t read = MockDS3231::onRead(out, n);
+			regs[0x0F] |= raise;
+			raise = 0;
+			return read;
+		}
+		uint8_t raise;
+};
+
+// Registers 0x00-0x06 for Saturday 2024-06-15 12:34:56
+static constexpr uint8_t saturdayRegs[7] = { 0x56, 0x34, 0x12, 0x06, 0x15, 0x06, 0x24 };
+static constexpr DateTime saturday = DS3231Registers::decodeTime(saturdayRegs);
+static_assert(saturday.year() == 2024 && saturday.month() == 6 && saturday.day() == 15,
+	"date decoded at compile time");
+static_assert(saturday.hour() == 12 && saturday.minute() == 34 && saturday.second() == 56,
+	"time decoded at compile time");
+static_assert(DS3231BCD::toBcd(59) == 0x59 && DS3231BCD::toDec(0x59) == 59, "BCD is constexpr");
+
+int main() {
+	// Every byte converts as with the original divide and modulo formulas
+	for (unsigned v = 0; v < 256; v++) {
+		CHECK_EQ(DS3231BCD::toDec(v), (uint8_t)(v / 16 * 10 + v % 16));
+		CHECK_EQ(DS3231BCD::toBcd(v), (uint8_t)(v / 10 * 16 + v % 10));
+	}
+
+	// Same results as the DS3231 class, on the same chip
+	RacingDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	DS3231Driver<TwoWire> driver(Wire);
+	CHECK_EQ(driver.getAddress(), 0x68);
+
+	DateTime set(2024, 6, 15, 12, 34, 56);
+	Wire.resetCounters();
+	CHECK(driver.adjust(set));
+	CHECK_EQ(Wire.counters.transactions, 1);
+	CHECK_EQ(chip.regs[0x03], 6);	// Saturday
+	for (uint8_t i = 0; i < 7; i++) {
+		CHECK_EQ(chip.regs[i], saturdayRegs[i]);
+	}
+	rtc.adjust(DateTime(2020, 1, 1, 0, 0, 0));
+	rtc.adjust(set);
+	for (uint8_t i = 0; i < 7; i++) {
+		CHECK_EQ(chip.regs[i], saturdayRegs[i]);
+	}
+
+	DateTime read;
+	Wire.resetCounters();
+	CHECK(driver.now(read));
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(read.unixtime(), set.unixtime());
+	CHECK_EQ(RTClib::now().unixtime(), set.unixtime());
+
+	chip.setTemperatureQuarters(-4 * 10 - 1);
+	CHECK(rtc.startTemperatureConversion());
+	delay(200);
+	int16_t viaDriver = 0, viaClass = 0;
+	CHECK(driver.getTemperatureQuarters(viaDriver));
+	CHECK(rtc.getTemperatureQuarters(viaClass));
+	CHECK_EQ(viaDriver, -41);
+	CHECK_EQ(viaDriver, viaClass);
+
+	chip.regs[0x0F] = 0x80 | 0x02;
+	CHECK(!driver.oscillatorCheck());
+	CHECK_EQ(driver.oscillatorCheck(), rtc.oscillatorCheck());
+	CHECK(!driver.checkIfAlarm(1));
+	CHECK(driver.checkIfAlarm(2, false));
+	CHECK_EQ(chip.regs[0x0F], 0x80 | 0x02);
+	CHECK(driver.checkIfAlarm(2));
+	CHECK_EQ(chip.regs[0x0F], 0x80);
+
+	// The other alarm firing between the read and the write is kept, and
+	// a failed write is reported
+	chip.regs[0x0F] = 0x01;
+	chip.raise = 0x02;
+	CHECK(driver.checkIfAlarm(1));
+	CHECK_EQ(chip.regs[0x0F], 0x02);
+	CHECK(driver.checkIfAlarm(2));
+	chip.regs[0x0F] = 0x01;
+	Wire.failNext(1, 2);
+	CHECK(!driver.checkIfAlarm(1));
+	CHECK_EQ(chip.regs[0x0F], 0x01);
+
+	// A chip at another address
+	MockDS3231 second(0x6A);
+	Wire.attach(&second);
+	DS3231Driver<TwoWire, 0x6A> secondDriver(Wire);
+	CHECK(secondDriver.adjust(DateTime(2030, 12, 31, 23, 59, 59)));
+	CHECK_EQ(second.regs[0x06], 0x30);
+	CHECK_EQ(chip.regs[0x06], 0x24);
+
+	// Bus errors
+	Wire.failNext(1);
+	CHECK(!driver.now(read));
+	DS3231Driver<TwoWire, 0x6B> missing(Wire);
+	CHECK(!missing.getTemperatureQuarters(viaDriver));
+
+	// Any class with the TwoWire functions can be the bus
+	RegisterFileBus file;
+	DS3231Driver<RegisterFileBus> fileDriver(file);
+	CHECK(fileDriver.adjust(set));
+	for (uint8_t i = 0; i < 7; i++) {
+		CHECK_EQ(file.regs[i], saturdayRegs[i]);
+	}
+	file.regs[0x11] = 0x19;
+	file.regs[0x12] = 0x40;
+	CHECK(fileDriver.getTemperatureQuarters(viaDriver));
+	CHECK_EQ(viaDriver, 25 * 4 + 1);
+	CHECK(fileDriver.now(read));
+	CHECK_EQ(read.unixtime(), set.unixtime());
+	CHECK(&fileDriver.getBus() == &file);
+	CHECK_EQ(file.calls, 5);
+
+	return checkReport("driver_test");
+}
@@ -0,0 +1,99 @@
+/*
+ * epoch_test.cpp
+ *
+ * EpochDateTime against DateTime over the whole 2000-2099 range, TimeSpan
+ * arithmetic and comparisons, and adjust() from either type.
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static_assert(TimeSpan(1, 2, 3, 4).totalseconds() == 93784L, "TimeSpan is constexpr");
+static_assert(TimeSpan(-93784L).days() == -1 && TimeSpan(-93784L).hours() == -2, "negative spans");
+static_assert((TimeSpan(90) - TimeSpan(30)).minutes() == 1, "span arithmetic");
+
+static uint32_t seed = 99;
+
+static uint32_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 4;
+}
+
+static void checkSame(const EpochDateTime& e, const DateTime& dt) {
+	CHECK_EQ(e.year(), dt.year());
+	CHECK_EQ(e.month(), dt.month());
+	CHECK_EQ(e.day(), dt.day());
+	CHECK_EQ(e.hour(), dt.hour());
+	CHECK_EQ(e.minute(), dt.minute());
+	CHECK_EQ(e.second(), dt.second());
+	CHECK_EQ(e.dayOfTheWeek(), dt.dayOfTheWeek());
+	CHECK_EQ(e.unixtime(), dt.unixtime());
+	CHECK_EQ(e.secondstime(), dt.secondstime());
+}
+
+int main() {
+	// Random times and every day boundary of 2000-2099
+	const uint32_t first = 946684800UL;		// 2000-01-01
+	const uint32_t last = 4102444799UL;		// 2099-12-31 23:59:59
+	for (uint32_t i = 0; i < 200000UL; i++) {
+		uint32_t t = first + nextRandom() % (last - first);
+		checkSame(EpochDateTime(t), DateTime(t));
+	}
+	for (uint32_t t = first; t < last; t += 86400UL) {
+		checkSame(EpochDateTime(t), DateTime(t));
+		checkSame(EpochDateTime(t - 1 + 86400UL), DateTime(t - 1 + 86400UL));
+	}
+	CHECK_EQ(DateTime(2000, 1, 1).secondstime(), 0);
+	CHECK_EQ(DateTime(2024, 2, 29, 12, 0, 1).secondstime(), 762523201L);
+
+	// Fields given up front, from either type
+	EpochDateTime leap(2024, 2, 29, 23, 59, 59);
+	checkSame(leap, DateTime(2024, 2, 29, 23, 59, 59));
+	DateTime original(2031, 7, 4, 6, 5, 4);
+	EpochDateTime converted = original;
+	checkSame(converted, original);
+	DateTime back = converted;
+	CHECK_EQ(back.unixtime(), original.unixtime());
+
+	// Arithmetic moves the seconds; the fields follow
+	EpochDateTime later = leap + TimeSpan(1);
+	checkSame(later, DateTime(2024, 3, 1, 0, 0, 0));
+	later -= TimeSpan(366, 0, 0, 0);
+	checkSame(later, DateTime(2023, 3, 1, 0, 0, 0));
+	later += TimeSpan(0, 1, 30, 0);
+	CHECK_EQ(later.hour(), 1);
+	CHECK_EQ(later.minute(), 30);
+	CHECK_EQ((leap - TimeSpan(0, 23, 59, 59)).hour(), 0);
+
+	TimeSpan gap = leap - later;
+	CHECK_EQ(gap.totalseconds(), (int32_t)(leap.unixtime() - later.unixtime()));
+	CHECK_EQ((later - leap).totalseconds(), -gap.totalseconds());
+	CHECK_EQ(gap.days(), 365);
+	CHECK_EQ(gap.hours(), 22);
+	CHECK_EQ((gap + TimeSpan(0, 0, 0, 1)).totalseconds(), gap.totalseconds() + 1);
+
+	// Comparisons
+	CHECK(later < leap);
+	CHECK(later <= leap);
+	CHECK(leap > later);
+	CHECK(leap >= leap);
+	CHECK(leap == EpochDateTime(2024, 2, 29, 23, 59, 59));
+	CHECK(leap != later);
+	CHECK(leap == DateTime(2024, 2, 29, 23, 59, 59));
+
+	// adjust() writes the same registers from either type
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	for (uint8_t i = 0; i < 50; i++) {
+		uint32_t t = first + nextRandom() % (last - first);
+		uint8_t fromDateTime[7];
+		rtc.adjust(DateTime(t));
+		memcpy(fromDateTime, chip.regs, 7);
+		rtc.adjust(EpochDateTime(t));
+		CHECK(memcmp(fromDateTime, chip.regs, 7) == 0);
+	}
+
+	return checkReport("epoch_test");
+}
@@ -0,0 +1,172 @@
+/*
+ * events_test.cpp
+ *
+ * DS3231Events: no bus access while no interrupt waits, one read, one
+ * write and a check read for both alarms, handlers with the interrupt
+ * time, an alarm that fires between the read and the clear, the depth and
+ * drop counters, and interrupts kept over a bus error. checkAlarms() on
+ * its own.
+ */
+
+#include <DS3231.h>
+#include <DS3231Events.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static uint8_t calls[3];
+static uint32_t times[3];
+
+// Raises flags in 0x0F right after the next read, as an alarm firing
+// between service()'s read and its clear would.
+class RacingDS3231 : public MockDS3231 {
+	public:
+		RacingDS3231() : raise(0) {}
+		virtual size_t onRead(uint8_t* out, size_t n) {
+			size_t read = MockDS3231::onRead(out, n);
+			regs[0x0F] |= raise;
+			raise = 0;
+			return read;
+		}
+		uint8_t raise;
+};
+
+static void onAlarm(uint8_t alarm, uint32_t time) {
+	calls[alarm]++;
+	times[alarm] = time;
+}
+
+int main() {
+	RacingDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	uint32_t buffer[4];
+	DS3231Events events(rtc, buffer, 4);
+	events.setHandler(1, onAlarm);
+	events.setHandler(2, onAlarm);
+	chip.regs[0x0E] = 0b00000111;		// INTCN, A2IE, A1IE
+
+	// Nothing queued: no bus access, even with a flag set
+	chip.regs[0x0F] = 0b00000001;
+	Wire.resetCounters();
+	CHECK_EQ(events.service(), 0);
+	CHECK_EQ(Wire.counters.transactions, 0);
+
+	// One alarm: one read, one write, one check
+	mockSetMicros(5000000UL);
+	events.onInterrupt();
+	CHECK_EQ(events.getDepth(), 1);
+	mockAdvanceMicros(20000);
+	Wire.resetCounters();
+	CHECK_EQ(events.service(), 1);
+	CHECK_EQ(Wire.counters.reads, 2);
+	CHECK_EQ(Wire.counters.writes, 3);
+	CHECK_EQ(chip.regs[0x0F] & 0x03, 0);
+	CHECK_EQ(calls[1], 1);
+	CHECK_EQ(times[1], 5000);
+	CHECK_EQ(calls[2], 0);
+	CHECK_EQ(events.getDepth(), 0);
+
+	// Both alarms: still one read, one write and one check
+	chip.regs[0x0F] = 0b10000011;
+	events.onInterrupt();
+	Wire.resetCounters();
+	CHECK_EQ(events.service(), 3);
+	CHECK_EQ(Wire.counters.transactions, 5);
+	CHECK_EQ(chip.regs[0x0F], 0b10000000);		// OSF left alone
+	CHECK_EQ(calls[1], 2);
+	CHECK_EQ(calls[2], 1);
+
+	// Alarm 2 fires between the read and the clear: its flag stays set,
+	// so the pin stays low and no edge comes. An interrupt is kept for it.
+	chip.regs[0x0F] = 0b00000001;
+	events.onInterrupt();
+	chip.raise = 0b00000010;
+	mockSetMicros(6000000UL);
+	CHECK_EQ(events.service(), 1);
+	CHECK_EQ(chip.regs[0x0F] & 0x03, 0b00000010);
+	CHECK_EQ(events.getDepth(), 1);
+	CHECK_EQ(calls[2], 1);
+	mockAdvanceMicros(50000);
+	CHECK_EQ(events.service(), 2);
+	CHECK_EQ(calls[2], 2);
+	CHECK(times[2] >= 6000 && times[2] < 6050);		// the check, not the second service()
+	CHECK_EQ(chip.regs[0x0F] & 0x03, 0);
+	CHECK_EQ(events.getDepth(), 0);
+
+	// An alarm whose interrupt is off is neither run nor cleared
+	chip.regs[0x0E] = 0b00000101;
+	chip.regs[0x0F] = 0b00000011;
+	events.onInterrupt();
+	CHECK_EQ(events.service(), 1);
+	CHECK_EQ(chip.regs[0x0F], 0b00000010);
+	CHECK_EQ(calls[2], 2);
+
+	// Full queue: drops counted, all taken at once with the oldest time
+	chip.regs[0x0F] = 0b00000001;
+	mockSetMicros(7000000UL);
+	for (uint8_t i = 0; i < 5; i++) {
+		events.onInterrupt();
+		mockAdvanceMicros(1000);
+	}
+	CHECK_EQ(events.getDepth(), 3);
+	CHECK_EQ(events.getMaxDepth(), 3);
+	CHECK_EQ(events.getDropped(), 2);
+	CHECK_EQ(events.service(), 1);
+	CHECK_EQ(times[1], 7000);
+	CHECK_EQ(events.getDepth(), 0);
+	CHECK_EQ(events.getMaxDepth(), 3);
+
+	// Interrupt without a flag: taken, nothing run
+	events.onInterrupt();
+	CHECK_EQ(events.service(), 0);
+	CHECK_EQ(events.getDepth(), 0);
+
+	// Bus error: nothing run, the interrupt stays queued until a
+	// service gets through
+	chip.regs[0x0F] = 0b00000001;
+	events.onInterrupt();
+	Wire.failNext(1);
+	CHECK_EQ(events.service(), 0);
+	CHECK_EQ(events.getDepth(), 1);
+	CHECK_EQ(calls[1], 5);
+	CHECK_EQ(events.service(), 1);
+	CHECK_EQ(calls[1], 6);
+
+	events.clear();
+	CHECK_EQ(events.getDepth(), 0);
+	CHECK_EQ(events.getMaxDepth(), 0);
+	CHECK_EQ(events.getDropped(), 0);
+
+	// Handlers are optional
+	events.setHandler(1, 0);
+	chip.regs[0x0F] = 0b00000001;
+	events.onInterrupt();
+	CHECK_EQ(events.service(), 1);
+	CHECK_EQ(calls[1], 6);
+
+	// checkAlarms() without the queue
+	chip.regs[0x0E] = 0b00000100;
+	chip.regs[0x0F] = 0b00000011;
+	CHECK_EQ(rtc.checkAlarms(true), 0);
+	Wire.resetCounters();
+	CHECK_EQ(rtc.checkAlarms(false, false), 3);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(chip.regs[0x0F], 0b00000011);
+	CHECK_EQ(rtc.checkAlarms(), 3);
+	CHECK_EQ(chip.regs[0x0F], 0);
+	// checkIfAlarm() leaves the other flag set when it fires in between,
+	// and writes nothing when the flag is clear.
+	chip.regs[0x0F] = 0b00000001;
+	chip.raise = 0b00000010;
+	CHECK(rtc.checkIfAlarm(1));
+	CHECK_EQ(chip.regs[0x0F], 0b00000010);
+	Wire.resetCounters();
+	CHECK(!rtc.checkIfAlarm(1));
+	CHECK_EQ(Wire.counters.transactions, 2);
+	chip.regs[0x0F] = 0;
+	Wire.failNext(1);
+	CHECK_EQ(rtc.checkAlarms(), 0);
+	CHECK(rtc.getLastError() != DS3231::BusOk);
+
+	return checkReport("events_test");
+}
@@ -0,0 +1,109 @@
+/*
+ * fleet_test.cpp
+ *
+ * DS3231 objects with their own address and mux channel, and a fleet
+ * sweep across two multiplexers and two buses.
+ */
+
+#include <DS3231.h>
+#include <DS3231Fleet.h>
+#include "MockDS3231.h"
+#include "MockMux.h"
+#include "check.h"
+
+// Ticks to the next second after a given number of reads.
+class TickingDS3231 : public MockDS3231 {
+	public:
+		TickingDS3231() : readsLeft(-1) {}
+		virtual size_t onRead(uint8_t* out, size_t n) {
+			if (readsLeft >= 0 && readsLeft-- == 0) advanceSeconds(1);
+			return MockDS3231::onRead(out, n);
+		}
+		int readsLeft;
+};
+
+int main() {
+	TwoWire Wire1;
+	MockMux mux0(0x70), mux1(0x71);
+	TickingDS3231 chipA;
+	MockDS3231 chipB(0x69), chipC, chipD, chipE(0x6A), chipF;
+	Wire.attach(&mux0);
+	Wire.attach(&mux1);
+	Wire.attach(&chipE);
+	Wire1.attach(&chipF);
+	mux0.attach(0, &chipA);
+	mux0.attach(0, &chipB);
+	mux0.attach(3, &chipC);
+	mux1.attach(1, &chipD);
+
+	chipA.setTime(24, 6, 15, 6, 12, 0, 0);
+	chipB.setTime(24, 6, 15, 6, 12, 0, 0);
+	chipC.setTime(24, 6, 15, 6, 12, 0, 1);
+	chipD.setTime(24, 6, 15, 6, 12, 0, 0);
+	chipE.setTime(24, 6, 15, 6, 12, 0, 2);
+	chipF.setTime(24, 6, 15, 6, 11, 59, 59);
+	const uint32_t noon = DateTime(2024, 6, 15, 12, 0, 0).unixtime();
+
+	DS3231 a(Wire, 0x68, 0x70, 0), b(Wire, 0x69, 0x70, 0), c(Wire, 0x68, 0x70, 3);
+	DS3231 d(Wire, 0x68, 0x71, 1), e(Wire, 0x6A), f(Wire1);
+
+	// A single clock behind a mux
+	DateTime dt;
+	CHECK(c.now(dt));
+	CHECK_EQ(dt.unixtime(), noon + 1);
+	CHECK_EQ(mux0.control, 0b00001000);
+	c.setMinute(30);
+	CHECK_EQ(chipC.regs[1], 0x30);
+	CHECK_EQ(chipA.regs[1], 0x00);
+	CHECK_EQ(mux0.selections, 1);	// still selected, not written again
+	chipC.regs[1] = 0x00;
+
+	// A clock without a mux closes the open channel first.
+	CHECK_EQ(e.getSecond(), 2);
+	CHECK_EQ(mux0.control, 0);
+
+	// Interleaved on purpose; the sweep groups clocks by channel.
+	DS3231 * clocks[] = { &a, &c, &b, &d, &e, &f };
+	uint32_t times[6];
+	DS3231Fleet fleet(clocks, times, 6);
+	mux0.selections = mux1.selections = 0;
+	Wire.resetCounters();
+	CHECK_EQ(fleet.sweep(), 6);
+	CHECK_EQ(Wire.counters.collisions, 0);
+	CHECK_EQ(mux0.collisions + mux1.collisions, 0);
+	// 0x70: channel 0, channel 3, closed for 0x71, and channel 0 again to
+	// re-read clock 0 at the end. 0x71: channel 1, closed for e.
+	CHECK_EQ(mux0.selections, 4);
+	CHECK_EQ(mux1.selections, 2);
+	CHECK_EQ(fleet.getConsensus(), noon);
+	CHECK_EQ(fleet.getOffset(0), 0);
+	CHECK_EQ(fleet.getOffset(1), 1);
+	CHECK_EQ(fleet.getOffset(2), 0);
+	CHECK_EQ(fleet.getOffset(3), 0);
+	CHECK_EQ(fleet.getOffset(4), 2);
+	CHECK_EQ(fleet.getOffset(5), -1);
+	CHECK_EQ(fleet.getTime(5), noon - 1);
+
+	// A clock that does not answer is left out of the consensus.
+	DS3231 missing(Wire, 0x6B, 0x71, 1);
+	clocks[3] = &missing;
+	chipE.setTime(24, 6, 15, 6, 12, 0, 3);
+	CHECK_EQ(fleet.sweep(), 5);
+	CHECK(!fleet.isValid(3));
+	CHECK_EQ(fleet.getOffset(3), 0);
+	CHECK_EQ(fleet.getConsensus(), noon);	// of -1, 0, 0, +1, +3
+	CHECK_EQ(Wire.counters.collisions, 0);
+
+	// The second ticks over during the sweep: it is repeated, so clock 0
+	// is compared with readings taken in the same second.
+	chipB.advanceSeconds(1);
+	chipC.advanceSeconds(1);
+	chipE.advanceSeconds(1);
+	chipF.advanceSeconds(1);
+	chipA.readsLeft = 1;	// after its first read in the sweep
+	CHECK_EQ(fleet.sweep(), 5);
+	CHECK_EQ(fleet.getConsensus(), noon + 1);
+	CHECK_EQ(fleet.getOffset(0), 0);
+
+	return checkReport("fleet_test");
+}
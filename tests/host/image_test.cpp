@@ -0,0 +1,173 @@
+/*
+ * image_test.cpp
+ *
+ * The bits3231 layout against the datasheet register map, and
+ * readImage()/applyImage(): saving and restoring a configuration, the
+ * transactions a diff costs, and the status flags left alone.
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+// Records the last value written to the status register 0x0F.
+class RecordingDS3231 : public MockDS3231 {
+	public:
+		RecordingDS3231() : status(0), statusWrites(0) {}
+		virtual void onWrite(const uint8_t* data, size_t n) {
+			if (n > 1 && data[0] <= 0x0F && data[0] + n - 1 > 0x0F) {
+				status = data[0x0F - data[0] + 1];
+				statusWrites++;
+			}
+			MockDS3231::onWrite(data, n);
+		}
+		uint8_t status;
+		unsigned statusWrites;
+};
+
+int main() {
+	RecordingDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	chip.setTime(24, 6, 15, 6, 12, 34, 56);
+
+	// Layout: one byte per register, bit 0 first
+	static const uint8_t regs[0x13] = {
+		0x56, 0x34, 0x72, 0x06, 0x15, 0x86, 0x24,	// 12:34:56 PM, 12-hour mode, century
+		0x80 | 0x45, 0x80 | 0x30, 0x40 | 0x07, 0x40 | 0x05,	// A1: M1, M2, 12-hour, DY/DT
+		0x80 | 0x10, 0x23, 0x31,	// A2: M2
+		0x80 | 0x1D,	// EOSC, RS2, RS1, INTCN, A1IE
+		0x80 | 0x08 | 0x02,	// OSF, EN32kHz, A2F
+		0xFB, 0x19, 0x40	// aging -5, 25.25 C
+	};
+	bits3231 image;
+	memcpy(&image, regs, sizeof(image));
+	CHECK_EQ(image.timeSec10 * 10 + image.timeSec, 56);
+	CHECK_EQ(image.timeMin10 * 10 + image.timeMin, 34);
+	CHECK_EQ(image.timeMode12, 1);
+	CHECK_EQ(image.timeAP20, 1);
+	CHECK_EQ(image.timeHour10 * 10 + image.timeHour, 12);
+	CHECK_EQ(image.timeDay, 6);
+	CHECK_EQ(image.timeDate10 * 10 + image.timeDate, 15);
+	CHECK_EQ(image.timeCentury, 1);
+	CHECK_EQ(image.timeMonth10 * 10 + image.timeMonth, 6);
+	CHECK_EQ(image.timeYear10 * 10 + image.timeYear, 24);
+	CHECK_EQ(image.A1M1, 1);
+	CHECK_EQ(image.A1Sec10 * 10 + image.A1Sec, 45);
+	CHECK_EQ(image.A1M2, 1);
+	CHECK_EQ(image.A1Min10 * 10 + image.A1Min, 30);
+	CHECK_EQ(image.A1Mode12, 1);
+	CHECK_EQ(image.A1M3, 0);
+	CHECK_EQ(image.A1DYDT, 1);
+	CHECK_EQ(image.A1DayDate, 5);
+	CHECK_EQ(image.A1M4, 0);
+	CHECK_EQ(image.A2M2, 1);
+	CHECK_EQ(image.A2Min10 * 10 + image.A2Min, 10);
+	CHECK_EQ(image.A2AP20 * 20 + image.A2Hour10 * 10 + image.A2Hour, 23);
+	CHECK_EQ(image.A2DYDT, 0);
+	CHECK_EQ(image.A2Date10 * 10 + image.A2DayDate, 31);
+	CHECK_EQ(image.EOSC, 1);
+	CHECK_EQ(image.BBSQW, 0);
+	CHECK_EQ(image.CONV, 0);
+	CHECK_EQ(image.RS2, 1);
+	CHECK_EQ(image.RS1, 1);
+	CHECK_EQ(image.INTCN, 1);
+	CHECK_EQ(image.A2IE, 0);
+	CHECK_EQ(image.A1IE, 1);
+	CHECK_EQ(image.OSF, 1);
+	CHECK_EQ(image.EN32KHZ, 1);
+	CHECK_EQ(image.BSY, 0);
+	CHECK_EQ(image.A2F, 1);
+	CHECK_EQ(image.A1F, 0);
+	CHECK_EQ(image.AgingOffset, -5);
+	CHECK_EQ(image.tempMSB, 25);
+	CHECK_EQ(image.tempLSB, 1);
+
+	// Save a configuration, change the device, restore it
+	rtc.setA1Time(1, 7, 30, 0, 0b1000, false, false, false);
+	rtc.setA2Time(1, 8, 0, 0b000, false, false, false);
+	rtc.turnOnAlarm(1);
+	rtc.setAgingOffset(3);
+	bits3231 saved;
+	CHECK(rtc.readImage(saved));
+	CHECK_EQ(saved.A1IE, 1);
+	CHECK_EQ(saved.AgingOffset, 3);
+	uint8_t savedRegs[0x13];
+	memcpy(savedRegs, chip.regs, sizeof(savedRegs));
+
+	rtc.setA1Time(2, 9, 45, 15, 0b0000, true, false, false);
+	rtc.turnOffAlarm(1);
+	rtc.enable32kHz(true);
+	rtc.setAgingOffset(-20);
+	CHECK(rtc.applyImage(saved));
+	CHECK(memcmp(chip.regs + 0x07, savedRegs + 0x07, 0x08) == 0);
+	CHECK_EQ(chip.regs[0x0F] & 0x08, savedRegs[0x0F] & 0x08);
+	CHECK_EQ(chip.regs[0x10], savedRegs[0x10]);
+	CHECK_EQ(chip.regs[0x00], 0x56);	// time left alone
+
+	// Already configured: the read alone
+	Wire.resetCounters();
+	CHECK(rtc.applyImage(saved));
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(Wire.counters.writes, 1);
+
+	// One register, and a gap of two bridged into one write
+	bits3231 changed = saved;
+	changed.A1IE = 0;
+	Wire.resetCounters();
+	CHECK(rtc.applyImage(changed));
+	CHECK_EQ(Wire.counters.writes, 2);
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 2);
+	CHECK_EQ(chip.regs[0x0E] & 0x01, 0);
+	changed.A1Sec = 9;		// 0x07
+	changed.A1Hour = 3;		// 0x09
+	Wire.resetCounters();
+	CHECK(rtc.applyImage(changed));
+	CHECK_EQ(Wire.counters.writes, 2);
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 4);
+	changed.A2Min = 7;		// 0x0B, three past 0x08: a second write
+	changed.A1Sec = 8;		// 0x07
+	Wire.resetCounters();
+	CHECK(rtc.applyImage(changed));
+	CHECK_EQ(Wire.counters.writes, 3);
+
+	// Flags are never cleared by an apply, even when 0x0F is written
+	chip.regs[0x0F] |= 0x03;
+	changed.EN32KHZ = !changed.EN32KHZ;
+	CHECK(rtc.applyImage(changed));
+	CHECK_EQ(chip.regs[0x0F] & 0x0B, 0x03 | (changed.EN32KHZ << 3));
+	CHECK(rtc.checkIfAlarm(1, false));
+
+	// ... and OSF is written back as it was read, not as 1
+	chip.regs[0x0F] &= ~0x80;
+	unsigned statusWrites = chip.statusWrites;
+	changed.EN32KHZ = !changed.EN32KHZ;
+	CHECK(rtc.applyImage(changed));
+	CHECK_EQ(chip.statusWrites, statusWrites + 1);
+	CHECK_EQ(chip.status & 0x80, 0);
+	CHECK_EQ(chip.status & 0x03, 0x03);
+	CHECK(rtc.oscillatorCheck());
+
+	// Groups: the aging offset only, and the time written whole
+	changed.AgingOffset = 12;
+	changed.A2Min = 1;
+	CHECK(rtc.applyImage(changed, DS3231::ImageAging));
+	CHECK_EQ((int8_t)chip.regs[0x10], 12);
+	CHECK_EQ(chip.regs[0x0B] & 0x0F, 7);
+	bits3231 timeImage;
+	CHECK(rtc.readImage(timeImage));
+	timeImage.timeSec = 0;
+	timeImage.timeSec10 = 0;
+	Wire.resetCounters();
+	CHECK(rtc.applyImage(timeImage, DS3231::ImageTime));
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 1 + 7);
+	CHECK_EQ(chip.regs[0x00], 0x00);
+
+	// Bus error
+	Wire.failNext(1);
+	CHECK(!rtc.applyImage(saved));
+	Wire.failNext(1);
+	CHECK(!rtc.readImage(image));
+
+	return checkReport("image_test");
+}
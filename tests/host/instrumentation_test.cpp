@@ -0,0 +1,63 @@
+/*
+ * instrumentation_test.cpp
+ *
+ * Counters, error tallies and latency histograms collected when the
+ * library is built with DS3231_INSTRUMENTATION.
+ *
+ * host-test-flags: -DDS3231_INSTRUMENTATION
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	DS3231Stats stats;
+
+	DS3231::resetStats();
+	rtc.getSecond();
+	rtc.setMinute(5);
+	RTClib::now();
+	DS3231::getStats(stats);
+	CHECK_EQ(stats.reads, 2);
+	CHECK_EQ(stats.writes, 1);
+	CHECK_EQ(stats.bytesRead, 1 + 7);
+	CHECK_EQ(stats.bytesWritten, 1);
+	CHECK_EQ(stats.readErrors, 0);
+	CHECK_EQ(stats.writeErrors, 0);
+	// At 100 kHz a one-byte read takes 400 us: bucket 3 (256 - 511 us).
+	CHECK_EQ(stats.readLatency[3], 1);
+	// A seven-byte read takes 940 us: bucket 4.
+	CHECK_EQ(stats.readLatency[4], 1);
+	// A one-byte write takes 290 us.
+	CHECK_EQ(stats.writeLatency[3], 1);
+
+	// Failed transactions are tallied.
+	Wire.failNext(1);
+	rtc.setMinute(6);
+	Wire.failNext(2);
+	rtc.getMinute();
+	DS3231::getStats(stats);
+	CHECK_EQ(stats.writeErrors, 1);
+	CHECK_EQ(stats.readErrors, 1);
+
+	// Interrupt-to-service time of an alarm.
+	DS3231::markAlarmInterrupt();
+	delay(5);
+	rtc.checkIfAlarm(1);
+	rtc.checkIfAlarm(1);	// no mark, not recorded
+	DS3231::getStats(stats);
+	CHECK_EQ(stats.alarmLatency[3], 1);
+	unsigned long total = 0;
+	for (int i = 0; i < DS3231_HISTOGRAM_BUCKETS; i++) total += stats.alarmLatency[i];
+	CHECK_EQ(total, 1);
+
+	DS3231::resetStats();
+	DS3231::getStats(stats);
+	CHECK_EQ(stats.reads + stats.writes + stats.readLatency[3], 0);
+
+	return checkReport("instrumentation_test");
+}
@@ -0,0 +1,111 @@
+/*
+ * journal_bench.cpp
+ *
+ * Storage per timestamp and append cost of DS3231Journal against a ring
+ * of raw 4-byte Unix times, for a few typical event streams. The byte
+ * counts hold on any board; host timings only compare the two rings with
+ * each other.
+ *
+ * Output is CSV on stdout: stream, bytes per timestamp raw and journal,
+ * nanoseconds per append raw and journal, and nanoseconds per peek() at a
+ * random index of the full journal.
+ */
+
+#include <chrono>
+#include <vector>
+#include <DS3231Journal.h>
+
+#define SAMPLES 10000
+#define ROUNDS 200
+#define PEEKS 100000
+
+static uint32_t seed = 3;
+
+static uint32_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 4;
+}
+
+// The same ring as the journal, storing every time whole
+struct RawRing {
+	uint32_t times[SAMPLES + 1];
+	volatile uint16_t head;
+	volatile uint16_t tail;
+
+	bool append(uint32_t unixtime) {
+		uint16_t next = head + 1 == SAMPLES + 1 ? 0 : head + 1;
+		if (next == tail) {
+			return false;
+		}
+		times[head] = unixtime;
+		head = next;
+		return true;
+	}
+};
+
+static std::vector<uint32_t> makeStream(uint32_t (*step)()) {
+	std::vector<uint32_t> times;
+	uint32_t t = 1700000000UL;
+	for (uint32_t i = 0; i < SAMPLES; i++) {
+		t += step();
+		times.push_back(t);
+	}
+	return times;
+}
+
+static uint32_t everySecond() { return 1; }
+static uint32_t severalPerSecond() { return nextRandom() % 4 == 0; }
+static uint32_t jitteredTenSeconds() { return 8 + nextRandom() % 5; }
+static uint32_t everyFiveMinutes() { return 300; }
+static uint32_t sporadic() { return nextRandom() % 10 == 0 ? 3600 + nextRandom() % 86400 : nextRandom() % 60; }
+
+static void report(const char* name, const std::vector<uint32_t>& times) {
+	static uint8_t storage[65535];
+	static RawRing raw;
+	DS3231Journal journal(storage, sizeof(storage));
+
+	double rawNs = 0, journalNs = 0;
+	for (uint16_t round = 0; round < ROUNDS; round++) {
+		raw.head = raw.tail = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < SAMPLES; i++) {
+			raw.append(times[i]);
+		}
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		rawNs += std::chrono::duration<double, std::nano>(end - start).count();
+
+		journal.clear();
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < SAMPLES; i++) {
+			journal.append(times[i]);
+		}
+		end = std::chrono::steady_clock::now();
+		journalNs += std::chrono::duration<double, std::nano>(end - start).count();
+	}
+
+	// peek() at random indices of the full journal
+	uint16_t count = journal.available();
+	uint32_t sink = 0, t;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < PEEKS; i++) {
+		journal.peek(nextRandom() % count, t);
+		sink += t;
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	if (sink == 1) printf("#");		// keeps the peeks from being optimized away
+	double peekNs = std::chrono::duration<double, std::nano>(end - start).count();
+
+	printf("%s,%.2f,%.2f,%.2f,%.2f,%.1f\n", name, (double)sizeof(uint32_t),
+		(double)journal.bytesUsed() / journal.available(),
+		rawNs / ROUNDS / SAMPLES, journalNs / ROUNDS / SAMPLES, peekNs / PEEKS);
+}
+
+int main() {
+	printf("stream,raw_bytes,journal_bytes,raw_ns_per_append,journal_ns_per_append,journal_ns_per_peek\n");
+	report("1 Hz", makeStream(everySecond));
+	report("4 per second", makeStream(severalPerSecond));
+	report("10 s jittered", makeStream(jitteredTenSeconds));
+	report("5 min", makeStream(everyFiveMinutes));
+	report("sporadic with gaps", makeStream(sporadic));
+	return 0;
+}
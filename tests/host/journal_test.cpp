@@ -0,0 +1,161 @@
+/*
+ * journal_test.cpp
+ *
+ * DS3231Journal: record sizes, forced checkpoints, and long random streams
+ * through a small ring with appends, reads and peeks interleaved, against
+ * a plain queue of Unix times. peek() over a large ring, in order and at
+ * random, past 65536 timestamps appended.
+ */
+
+#include <deque>
+#include <DS3231Journal.h>
+#include "check.h"
+
+static uint32_t seed = 7;
+
+static uint32_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 4;
+}
+
+// Mostly short steps, with the record size boundaries, gaps and steps
+// back mixed in
+static uint32_t nextTime(uint32_t t) {
+	static const int32_t edges[] = { 0, 239, 240, 4079, 4080, 86400, -1, -3600 };
+	uint32_t r = nextRandom() % 100;
+	if (r < 70) return t + nextRandom() % 10;
+	if (r < 90) return t + nextRandom() % 4080;
+	return t + edges[nextRandom() % 8];
+}
+
+int main() {
+	uint8_t storage[64];
+	const uint32_t t0 = 1700000000UL;
+
+	// Record sizes: checkpoint, one byte, two bytes, checkpoint again for
+	// a gap and for a step back
+	DS3231Journal journal(storage, sizeof(storage));
+	CHECK_EQ(journal.getCapacity(), 63);
+	CHECK(journal.append(t0));
+	CHECK_EQ(journal.bytesUsed(), 5);
+	CHECK(journal.append(t0 + 239));
+	CHECK_EQ(journal.bytesUsed(), 6);
+	CHECK(journal.append(t0 + 239 + 240));
+	CHECK_EQ(journal.bytesUsed(), 8);
+	CHECK(journal.append(t0 + 239 + 240 + 4079));
+	CHECK_EQ(journal.bytesUsed(), 10);
+	CHECK(journal.append(t0 + 239 + 240 + 4079 + 4080));
+	CHECK_EQ(journal.bytesUsed(), 15);
+	CHECK(journal.append(t0));
+	CHECK_EQ(journal.bytesUsed(), 20);
+	CHECK_EQ(journal.available(), 6);
+
+	uint32_t t;
+	CHECK(journal.peek(3, t));
+	CHECK_EQ(t, t0 + 239 + 240 + 4079);
+	CHECK(!journal.peek(6, t));
+	CHECK(journal.read(t));
+	CHECK_EQ(t, t0);
+	DateTime dt;
+	CHECK(journal.read(dt));
+	CHECK_EQ(dt.unixtime(), t0 + 239);
+	CHECK_EQ(journal.available(), 4);
+
+	// A checkpoint every interval timestamps, even for short steps
+	DS3231Journal every4(storage, sizeof(storage), 4);
+	for (uint8_t i = 0; i < 8; i++) {
+		CHECK(every4.append(t0 + i));
+	}
+	CHECK_EQ(every4.bytesUsed(), 16);
+
+	// Full: refused and counted, and the stream carries on correctly
+	// from the last timestamp stored
+	DS3231Journal full(storage, 16);
+	CHECK(full.append(t0));
+	for (uint8_t i = 1; i <= 10; i++) {
+		CHECK(full.append(t0 + i));
+	}
+	CHECK(!full.append(t0 + 11));
+	CHECK(!full.append(t0 + 12));
+	CHECK_EQ(full.getDropped(), 2);
+	CHECK(full.read(t));
+	CHECK(full.append(t0 + 13));
+	for (uint8_t i = 1; i <= 10; i++) {
+		CHECK(full.read(t));
+		CHECK_EQ(t, t0 + i);
+	}
+	CHECK(full.read(t));
+	CHECK_EQ(t, t0 + 13);
+	CHECK(!full.read(t));
+	full.clear();
+	CHECK_EQ(full.getDropped(), 0);
+	CHECK_EQ(full.available(), 0);
+
+	// Random streams through a ring that wraps many times
+	for (uint8_t size = 6; size < 64; size += 7) {
+		DS3231Journal ring(storage, size, 1 + nextRandom() % 40);
+		std::deque<uint32_t> expected;
+		uint32_t now = t0;
+		uint32_t dropped = 0;
+		for (uint32_t step = 0; step < 20000; step++) {
+			uint32_t r = nextRandom() % 8;
+			if (r < 4) {
+				now = nextTime(now);
+				if (ring.append(now)) {
+					expected.push_back(now);
+				} else {
+					dropped++;
+				}
+			} else if (r < 7) {
+				bool ok = ring.read(t);
+				CHECK_EQ(ok, !expected.empty());
+				if (ok) {
+					CHECK_EQ(t, expected.front());
+					expected.pop_front();
+				}
+			} else if (!expected.empty()) {
+				uint16_t index = nextRandom() % expected.size();
+				CHECK(ring.peek(index, t));
+				CHECK_EQ(t, expected[index]);
+			}
+			CHECK_EQ(ring.available(), expected.size());
+			CHECK(ring.bytesUsed() <= ring.getCapacity());
+		}
+		CHECK_EQ(ring.getDropped(), (uint16_t)dropped);
+	}
+
+	// A large ring: scans and random peeks seek from the checkpoint
+	// index and the previous peek, also once the timestamp counts wrap
+	static uint8_t large[4096];
+	DS3231Journal big(large, sizeof(large), 16);
+	std::deque<uint32_t> kept;
+	uint32_t now = t0;
+	for (uint32_t round = 0; round < 40; round++) {
+		while (true) {
+			now = nextTime(now);
+			if (!big.append(now)) break;
+			kept.push_back(now);
+		}
+		for (uint16_t i = 0; i < kept.size(); i++) {
+			CHECK(big.peek(i, t));
+			CHECK_EQ(t, kept[i]);
+		}
+		for (uint16_t i = 0; i < 200; i++) {
+			uint16_t index = nextRandom() % kept.size();
+			CHECK(big.peek(index, t));
+			CHECK_EQ(t, kept[index]);
+		}
+		for (uint16_t i = kept.size(); i-- > 0;) {
+			CHECK(big.peek(i, t));
+			CHECK_EQ(t, kept[i]);
+		}
+		while (kept.size() > 100) {
+			CHECK(big.read(t));
+			CHECK_EQ(t, kept.front());
+			kept.pop_front();
+		}
+	}
+	CHECK(big.getDropped() == 40);
+
+	return checkReport("journal_test");
+}
@@ -0,0 +1,376 @@
+/*
+ * mock.cpp
+ *
+ * Implementation of the host stand-ins for the Arduino core, TwoWire and
+ * the DS3231 register model used by the tests in this directory.
+ */
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "MockDS3231.h"
+#include "MockMux.h"
+
+/*****************************************
+	Simulated Arduino core
+ *****************************************/
+
+static unsigned long mockMicros = 0;
+static uint8_t pinLevels[64];
+
+unsigned long millis() { return mockMicros / 1000UL; }
+unsigned long micros() { return mockMicros; }
+void delay(unsigned long ms) { mockMicros += ms * 1000UL; }
+void delayMicroseconds(unsigned int us) { mockMicros += us; }
+void mockAdvanceMicros(unsigned long us) { mockMicros += us; }
+void mockSetMicros(unsigned long us) { mockMicros = us; }
+
+static bool pinHeld[64];
+static uint8_t pinModes[64];
+static unsigned long pinPulses[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (pin >= sizeof(pinLevels)) return;
+	pinModes[pin] = mode;
+	if (mode != OUTPUT) pinLevels[pin] = HIGH;
+	else if (pinLevels[pin] == LOW) pinPulses[pin]++;
+}
+void digitalWrite(uint8_t pin, uint8_t val) {
+	if (pin >= sizeof(pinLevels)) return;
+	if (pinModes[pin] == OUTPUT && val == LOW && pinLevels[pin] != LOW) pinPulses[pin]++;
+	pinLevels[pin] = val;
+}
+int digitalRead(uint8_t pin) {
+	if (pin >= sizeof(pinLevels) || pinHeld[pin]) return LOW;
+	return pinLevels[pin];
+}
+void mockHoldLow(uint8_t pin, bool hold) {
+	if (pin < sizeof(pinLevels)) pinHeld[pin] = hold;
+}
+unsigned long mockPulses(uint8_t pin) {
+	return pin < sizeof(pinLevels) ? pinPulses[pin] : 0;
+}
+
+/*****************************************
+	Simulated TwoWire
+ *****************************************/
+
+TwoWire Wire;
+
+TwoWire::TwoWire() : beginCount(0), clockHz(100000UL), wireTimeout(25000UL), wireTimeoutReset(false),
+	deviceCount(0), txAddress(0), txLength(0), txOverflow(false), rxLength(0), rxIndex(0), failures(0),
+	skips(0), hangs(0), timeoutFlag(false) {
+	resetCounters();
+}
+
+void TwoWire::begin() {
+	beginCount++;
+}
+
+void TwoWire::attach(MockI2CDevice* device) {
+	if (deviceCount < sizeof(devices) / sizeof(devices[0])) {
+		devices[deviceCount++] = device;
+	}
+}
+
+void TwoWire::spend(unsigned long bits) {
+	counters.bitTimes += bits;
+	mockAdvanceMicros(bits * 1000000UL / clockHz);
+}
+
+bool TwoWire::hang() {
+	if (!hangs) return false;
+	hangs--;
+	counters.errors++;
+	timeoutFlag = true;
+	mockAdvanceMicros(wireTimeout);
+	return true;
+}
+
+bool TwoWire::fail() {
+	if (skips) {
+		skips--;
+		return false;
+	}
+	if (!failures) return false;
+	failures--;
+	return true;
+}
+
+void TwoWire::resetCounters() {
+	memset(&counters, 0, sizeof(counters));
+}
+
+MockI2CDevice* TwoWire::find(uint8_t address) {
+	MockI2CDevice* first = 0;
+	for (uint8_t i = 0; i < deviceCount; i++) {
+		MockI2CDevice* found = devices[i]->route(address);
+		if (found && first) counters.collisions++;
+		if (found && !first) first = found;
+	}
+	return first;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+	txAddress = address;
+	txLength = 0;
+	txOverflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+	if (txLength >= BUFFER_LENGTH) {
+		txOverflow = true;
+		return 0;
+	}
+	txBuffer[txLength++] = data;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+	size_t n = 0;
+	while (n < quantity && write(data[n])) n++;
+	return n;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t) {
+	counters.transactions++;
+	counters.writes++;
+	if (hang()) {
+		return 5;
+	}
+	spend(2 + 9UL * (1 + txLength));
+	if (txOverflow) {
+		counters.errors++;
+		return 1;
+	}
+	MockI2CDevice* device = find(txAddress);
+	if (fail()) {
+		counters.errors++;
+		return 4;
+	}
+	if (!device) {
+		counters.errors++;
+		return 2;
+	}
+	counters.bytesWritten += txLength;
+	device->onWrite(txBuffer, txLength);
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t) {
+	if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+	counters.transactions++;
+	counters.reads++;
+	rxIndex = 0;
+	rxLength = 0;
+	if (hang()) {
+		return 0;
+	}
+	MockI2CDevice* device = find(address);
+	if (fail() || !device) {
+		counters.errors++;
+		spend(2 + 9);
+		return 0;
+	}
+	rxLength = device->onRead(rxBuffer, quantity);
+	counters.bytesRead += rxLength;
+	spend(2 + 9UL * (1 + rxLength));
+	return rxLength;
+}
+
+int TwoWire::available() {
+	return rxLength - rxIndex;
+}
+
+int TwoWire::read() {
+	return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+	return rxIndex < rxLength ? rxBuffer[rxIndex] : -1;
+}
+
+/*****************************************
+	Simulated DS3231
+ *****************************************/
+
+static uint8_t toBcd(uint8_t v) { return ((v / 10) << 4) | (v % 10); }
+static uint8_t fromBcd(uint8_t v) { return (v >> 4) * 10 + (v & 0x0F); }
+
+MockDS3231::MockDS3231(uint8_t address) : MockI2CDevice(address), pointer(0),
+	conversionMicros(125000UL), conversionsStarted(0), nextTemperature(25 * 4),
+	converting(false), conversionStart(0) {
+	memset(regs, 0, sizeof(regs));
+	regs[0x0E] = 0b00011100;	// power-on default: RS2, RS1, INTCN
+	regs[0x0F] = 0b10001000;	// power-on default: OSF, EN32kHz
+	regs[0x11] = 25;
+}
+
+void MockDS3231::update() {
+	if (converting && micros() - conversionStart >= conversionMicros) {
+		converting = false;
+		regs[0x11] = (uint8_t)(nextTemperature >> 2);
+		regs[0x12] = (uint8_t)((nextTemperature & 0x03) << 6);
+		regs[0x0E] &= ~0b00100000;	// CONV
+		regs[0x0F] &= ~0b00000100;	// BSY
+	}
+}
+
+void MockDS3231::onWrite(const uint8_t* data, size_t n) {
+	update();
+	if (n == 0) return;
+	pointer = data[0] % 0x13;
+	for (size_t i = 1; i < n; i++) {
+		uint8_t v = data[i];
+		switch (pointer) {
+		case 0x0E:
+			if ((v & 0b00100000) && !converting && !(regs[0x0F] & 0b00000100)) {
+				converting = true;
+				conversionStart = micros();
+				conversionsStarted++;
+				regs[0x0F] |= 0b00000100;
+			} else if (converting) {
+				v |= 0b00100000;	// CONV stays set until done
+			} else {
+				v &= ~0b00100000;
+			}
+			regs[0x0E] = v;
+			break;
+		case 0x0F:
+			// OSF, A2F and A1F can only be cleared; BSY is read-only.
+			regs[0x0F] = (regs[0x0F] & v & 0b10000011)
+					| (v & 0b00001000) | (regs[0x0F] & 0b00000100);
+			break;
+		case 0x11:
+		case 0x12:
+			break;
+		default:
+			regs[pointer] = v;
+		}
+		pointer = (pointer + 1) % 0x13;
+	}
+}
+
+size_t MockDS3231::onRead(uint8_t* out, size_t n) {
+	update();
+	for (size_t i = 0; i < n; i++) {
+		out[i] = regs[pointer];
+		pointer = (pointer + 1) % 0x13;
+	}
+	return n;
+}
+
+void MockDS3231::setTime(uint8_t year, uint8_t month, uint8_t date, uint8_t dow,
+		uint8_t hour, uint8_t minute, uint8_t second) {
+	regs[0] = toBcd(second);
+	regs[1] = toBcd(minute);
+	regs[2] = toBcd(hour);
+	regs[3] = dow;
+	regs[4] = toBcd(date);
+	regs[5] = toBcd(month);
+	regs[6] = toBcd(year);
+}
+
+void MockDS3231::setTemperatureQuarters(int16_t quarters) {
+	nextTemperature = quarters;
+}
+
+void MockDS3231::advanceSeconds(unsigned long seconds) {
+	while (seconds--) {
+		tick();
+		checkAlarms();
+	}
+}
+
+void MockDS3231::tick() {
+	static const uint8_t monthDays[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+	uint8_t s = fromBcd(regs[0] & 0x7F) + 1;
+	if (s < 60) { regs[0] = toBcd(s); return; }
+	regs[0] = 0;
+	uint8_t mi = fromBcd(regs[1] & 0x7F) + 1;
+	if (mi < 60) { regs[1] = toBcd(mi); return; }
+	regs[1] = 0;
+	uint8_t h = fromBcd(regs[2] & 0x3F) + 1;
+	if (h < 24) { regs[2] = toBcd(h); return; }
+	regs[2] = 0;
+	regs[3] = regs[3] % 7 + 1;
+	uint8_t y = fromBcd(regs[6]);
+	uint8_t m = fromBcd(regs[5] & 0x1F);
+	uint8_t dim = monthDays[m - 1] + (m == 2 && (y % 4) == 0);
+	uint8_t d = fromBcd(regs[4] & 0x3F) + 1;
+	if (d <= dim) { regs[4] = toBcd(d); return; }
+	regs[4] = 1;
+	uint8_t century = regs[5] & 0x80;
+	if (++m <= 12) { regs[5] = century | toBcd(m); return; }
+	regs[5] = 1;
+	if (++y < 100) { regs[6] = toBcd(y); regs[5] |= century; return; }
+	regs[6] = 0;
+	regs[5] |= century ^ 0x80;
+}
+
+void MockDS3231::checkAlarms() {
+	bool dayMatch;
+	// Alarm 1
+	bool match = true;
+	if (!(regs[0x07] & 0x80)) match = match && regs[0x00] == (regs[0x07] & 0x7F);
+	if (!(regs[0x08] & 0x80)) match = match && regs[0x01] == (regs[0x08] & 0x7F);
+	if (!(regs[0x09] & 0x80)) match = match && (regs[0x02] & 0x7F) == (regs[0x09] & 0x7F);
+	if (!(regs[0x0A] & 0x80)) {
+		if (regs[0x0A] & 0x40) dayMatch = regs[0x03] == (regs[0x0A] & 0x0F);
+		else dayMatch = regs[0x04] == (regs[0x0A] & 0x3F);
+		match = match && dayMatch;
+	}
+	if (match) regs[0x0F] |= 0x01;
+	// Alarm 2 only ever fires with seconds == 00
+	match = regs[0x00] == 0;
+	if (!(regs[0x0B] & 0x80)) match = match && regs[0x01] == (regs[0x0B] & 0x7F);
+	if (!(regs[0x0C] & 0x80)) match = match && (regs[0x02] & 0x7F) == (regs[0x0C] & 0x7F);
+	if (!(regs[0x0D] & 0x80)) {
+		if (regs[0x0D] & 0x40) dayMatch = regs[0x03] == (regs[0x0D] & 0x0F);
+		else dayMatch = regs[0x04] == (regs[0x0D] & 0x3F);
+		match = match && dayMatch;
+	}
+	if (match) regs[0x0F] |= 0x02;
+}
+
+/*****************************************
+	Simulated I2C multiplexer
+ *****************************************/
+
+MockMux::MockMux(uint8_t address) : MockI2CDevice(address), control(0),
+	selections(0), collisions(0) {
+	memset(children, 0, sizeof(children));
+}
+
+void MockMux::attach(uint8_t channel, MockI2CDevice* device) {
+	for (uint8_t i = 0; i < MOCK_MUX_DEVICES; i++) {
+		if (!children[channel][i]) {
+			children[channel][i] = device;
+			return;
+		}
+	}
+}
+
+MockI2CDevice* MockMux::route(uint8_t address) {
+	if (address == i2cAddress) return this;
+	MockI2CDevice* first = 0;
+	for (uint8_t channel = 0; channel < 8; channel++) {
+		if (!(control & (1 << channel))) continue;
+		for (uint8_t i = 0; i < MOCK_MUX_DEVICES && children[channel][i]; i++) {
+			MockI2CDevice* found = children[channel][i]->route(address);
+			if (found && first) collisions++;
+			if (found && !first) first = found;
+		}
+	}
+	return first;
+}
+
+void MockMux::onWrite(const uint8_t* data, size_t n) {
+	if (n == 0) return;
+	control = data[n - 1];
+	selections++;
+}
+
+size_t MockMux::onRead(uint8_t* out, size_t n) {
+	for (size_t i = 0; i < n; i++) out[i] = control;
+	return n;
+}
@@ -0,0 +1,158 @@
+/*
+ * prediction_test.cpp
+ *
+ * Next-fire-time prediction for both alarms, checked against the simulated
+ * clock: every mask combination, random start times, month ends and
+ * impossible alarms.
+ */
+
+#include <string.h>
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static MockDS3231 chip;
+static DS3231 rtc;
+
+static uint32_t seed = 12345;
+
+static uint32_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 8;
+}
+
+static uint32_t chipTime() {
+	bool century;
+	bool h12, pm;
+	return DateTime(2000 + rtc.getYear(), rtc.getMonth(century), rtc.getDate(),
+		rtc.getHour(h12, pm), rtc.getMinute(), rtc.getSecond()).unixtime();
+}
+
+// Runs the simulated clock until the alarm flag of Alarm comes up and
+// returns the time at which it did, or 0 if it did not within limit
+// seconds. Skips ahead an hour at a time and backs up on a hit.
+static uint32_t runToAlarm(byte Alarm, uint32_t limit) {
+	uint8_t flag = Alarm == 1 ? 0x01 : 0x02;
+	uint8_t saved[sizeof(chip.regs)];
+	uint32_t elapsed = 0;
+	chip.regs[0x0F] &= ~flag;
+	while (elapsed < limit) {
+		memcpy(saved, chip.regs, sizeof(saved));
+		chip.advanceSeconds(3600);
+		if (!(chip.regs[0x0F] & flag)) {
+			elapsed += 3600;
+			continue;
+		}
+		memcpy(chip.regs, saved, sizeof(saved));
+		do {
+			chip.advanceSeconds(1);
+		} while (!(chip.regs[0x0F] & flag));
+		rtc.invalidateShadow();
+		return chipTime();
+	}
+	return 0;
+}
+
+static void setChip(const DateTime& dt, byte dow) {
+	chip.setTime(dt.year() - 2000, dt.month(), dt.day(), dow, dt.hour(), dt.minute(), dt.second());
+	rtc.invalidateShadow();
+}
+
+// Predicts three alarms from the chip's time, then lets the simulated
+// clock run into each of them.
+static void checkAgainstClock(byte Alarm, const DateTime& from, byte dow) {
+	DateTime next[3];
+	setChip(from, dow);
+	CHECK_EQ(rtc.getNextAlarms(Alarm, next, 3), 3);
+	for (byte i = 0; i < 3; i++) {
+		uint32_t fired = runToAlarm(Alarm, 70UL * 86400UL);
+		if (fired != next[i].unixtime()) {
+			printf("  alarm %d from %lu (dow %d): predicted %lu, fired %lu\n", Alarm,
+				(unsigned long)from.unixtime(), dow,
+				(unsigned long)next[i].unixtime(), (unsigned long)fired);
+		}
+		CHECK_EQ(fired, next[i].unixtime());
+	}
+}
+
+static DateTime randomTime() {
+	// 2023-01-01 plus up to about two years
+	return DateTime(1672531200UL + nextRandom() % (2UL * 365 * 86400));
+}
+
+int main() {
+	Wire.attach(&chip);
+
+	// Every mask combination of both alarms, by date and by day of week,
+	// with random alarm fields and random start times
+	for (byte bits = 0; bits < 16; bits++) {
+		for (byte dy = 0; dy < 2; dy++) {
+			byte day = dy ? 1 + nextRandom() % 7 : 1 + nextRandom() % 28;
+			rtc.setA1Time(day, nextRandom() % 24, nextRandom() % 60, nextRandom() % 60,
+				bits, dy, false, false);
+			checkAgainstClock(1, randomTime(), 1 + nextRandom() % 7);
+		}
+	}
+	for (byte bits = 0; bits < 8; bits++) {
+		for (byte dy = 0; dy < 2; dy++) {
+			byte day = dy ? 1 + nextRandom() % 7 : 1 + nextRandom() % 28;
+			rtc.setA2Time(day, nextRandom() % 24, nextRandom() % 60,
+				bits << 4, dy, false, false);
+			checkAgainstClock(2, randomTime(), 1 + nextRandom() % 7);
+		}
+	}
+
+	// Start times on and just around the alarm
+	rtc.setA1Time(15, 8, 30, 0, 0x00, false, false, false);
+	checkAgainstClock(1, DateTime(2024, 3, 15, 8, 30, 0), 5);
+	checkAgainstClock(1, DateTime(2024, 3, 15, 8, 29, 59), 5);
+	checkAgainstClock(1, DateTime(2024, 12, 31, 23, 59, 59), 2);
+	rtc.setA2Time(1, 0, 0, 0x70, false, false, false);
+	checkAgainstClock(2, DateTime(2024, 3, 15, 23, 59, 59), 5);
+	checkAgainstClock(2, DateTime(2024, 3, 15, 23, 59, 0), 5);
+
+	// Dates that some months do not have
+	rtc.setA1Time(31, 12, 0, 0, 0x00, false, false, false);
+	checkAgainstClock(1, DateTime(2023, 1, 31, 12, 0, 0), 2);
+	rtc.setA1Time(30, 0, 0, 0, 0x00, false, false, false);
+	checkAgainstClock(1, DateTime(2023, 1, 30, 0, 0, 1), 1);
+	rtc.setA2Time(29, 6, 0, 0x00, false, false, false);
+	checkAgainstClock(2, DateTime(2023, 2, 1, 0, 0, 0), 3);
+	checkAgainstClock(2, DateTime(2024, 2, 1, 0, 0, 0), 4);
+
+	// Alarms that can never go off
+	DateTime next[2];
+	setChip(DateTime(2024, 3, 15, 8, 0, 0), 5);
+	rtc.setA1Time(32, 8, 0, 0, 0x00, false, false, false);
+	CHECK_EQ(rtc.getNextAlarms(1, next, 2), 0);
+	rtc.setA1Time(1, 8, 0, 0, 0x00, true, false, false);
+	CHECK_EQ(rtc.getNextAlarms(1, next, 2), 2);
+	rtc.setA1Time(0, 8, 0, 0, 0x00, true, false, false);
+	CHECK_EQ(rtc.getNextAlarms(1, next, 2), 0);
+	rtc.setA1Time(1, 8, 0, 75, 0x0E, false, false, false);
+	CHECK_EQ(rtc.getNextAlarms(1, next, 2), 0);
+	CHECK_EQ(rtc.getNextAlarms(1, next, 0), 0);
+
+	// A bus error reports nothing
+	rtc.setA1Time(1, 8, 0, 0, 0x0F, false, false, false);
+	Wire.failNext(1);
+	CHECK_EQ(rtc.getNextAlarms(1, next, 2), 0);
+
+	// 12-hour alarm fields predict the same times as their 24-hour form
+	const byte hours12[] = { 12, 1, 11, 12, 7, 11 };
+	const bool pm12[] = { false, false, false, true, true, true };
+	const byte hours24[] = { 0, 1, 11, 12, 19, 23 };
+	for (byte i = 0; i < sizeof(hours12); i++) {
+		DateTime from = randomTime();
+		DateTime a, b;
+		CHECK(DS3231::nextA1Time(from, 3, 0, hours12[i], 15, 0, 0x08, false, true, pm12[i], a));
+		CHECK(DS3231::nextA1Time(from, 3, 0, hours24[i], 15, 0, 0x08, false, false, false, b));
+		CHECK_EQ(a.unixtime(), b.unixtime());
+		CHECK(DS3231::nextA2Time(from, 3, 4, hours12[i], 15, 0x00, true, true, pm12[i], a));
+		CHECK(DS3231::nextA2Time(from, 3, 4, hours24[i], 15, 0x00, true, false, false, b));
+		CHECK_EQ(a.unixtime(), b.unixtime());
+		CHECK_EQ(a.hour(), hours24[i]);
+	}
+
+	return checkReport("prediction_test");
+}
@@ -0,0 +1,160 @@
+/*
+ * scheduler_test.cpp
+ *
+ * Many software alarms on Alarm 1, with simulated time fast-forwarded a
+ * second or a month at a time.
+ */
+
+#include <DS3231.h>
+#include <DS3231Scheduler.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static MockDS3231 chip;
+static DS3231 rtc;
+static DS3231Scheduler::Entry storage[8];
+static DS3231Scheduler scheduler(rtc, storage, 8);
+
+static uint32_t simNow;			// Unix time of the simulated chip
+static unsigned late;			// callbacks run after their due time
+static unsigned fired[256];
+static uint32_t lastFired[256];
+static uint32_t expectedDue[256];
+
+static void record(uint8_t id) {
+	fired[id]++;
+	lastFired[id] = simNow;
+	if (simNow != expectedDue[id]) late++;
+}
+
+static void periodic(uint8_t id) {
+	record(id);
+	expectedDue[id] += 60;
+}
+
+static void cancelAfterThree(uint8_t id) {
+	record(id);
+	expectedDue[id] += 7;
+	if (fired[id] == 3) scheduler.cancel(id);
+}
+
+static void setChip(const DateTime & dt) {
+	chip.setTime(dt.year() - 2000, dt.month(), dt.day(), 1, dt.hour(), dt.minute(), dt.second());
+	simNow = dt.unixtime();
+}
+
+static void tick(unsigned long seconds) {
+	chip.advanceSeconds(seconds);
+	simNow += seconds;
+}
+
+int main() {
+	Wire.attach(&chip);
+	setChip(DateTime(2024, 6, 15, 12, 0, 0));
+	const uint32_t start = simNow;
+
+	uint8_t once = scheduler.add(start + 10, record);
+	uint8_t minute = scheduler.add(start + 30, periodic, 60);
+	uint8_t three = scheduler.add(start + 5, cancelAfterThree, 7);
+	uint8_t later = scheduler.add(start + 3600, record);
+	expectedDue[once] = start + 10;
+	expectedDue[minute] = start + 30;
+	expectedDue[three] = start + 5;
+	expectedDue[later] = start + 3600;
+	CHECK_EQ(scheduler.size(), 4);
+	CHECK_EQ(scheduler.next(), start + 5);
+	CHECK(scheduler.cancel(later));
+	CHECK(!scheduler.cancel(later));
+
+	// The first service() programs Alarm 1 and arms it.
+	CHECK_EQ(scheduler.service(), 0);
+	CHECK_EQ(chip.regs[0x0E] & 0b101, 0b101);	// INTCN, A1IE
+	CHECK_EQ(chip.regs[0x07], 0x05);			// seconds
+	CHECK_EQ(chip.regs[0x0A], 0x15);			// date match
+
+	// Two hours, one second at a time
+	unsigned long idleTransactions = 0, idleCalls = 0;
+	for (int s = 0; s < 7200; s++) {
+		tick(1);
+		Wire.resetCounters();
+		if (scheduler.service() == 0) {
+			idleTransactions += Wire.counters.transactions;
+			idleCalls++;
+		}
+	}
+	CHECK_EQ(late, 0);
+	CHECK_EQ(fired[once], 1);
+	CHECK_EQ(fired[three], 3);
+	CHECK_EQ(fired[minute], 120);
+	CHECK_EQ(fired[later], 0);
+	CHECK_EQ(scheduler.size(), 1);
+	// Idle passes: one status read (address write + read), nothing else
+	CHECK_EQ(idleTransactions, idleCalls * 2);
+
+	// An unchanged next alarm is not rewritten.
+	Wire.resetCounters();
+	uint8_t same = scheduler.add(scheduler.next(), record);
+	scheduler.service();
+	CHECK_EQ(Wire.counters.writes, 1 + 1);	// status pointer, time pointer
+	CHECK(scheduler.cancel(minute));
+	CHECK(scheduler.cancel(same));
+
+	// Empty queue: Alarm 1 is switched off.
+	CHECK_EQ(scheduler.size(), 0);
+	scheduler.service();
+	CHECK_EQ(chip.regs[0x0E] & 0b001, 0);
+
+	// More than a month ahead: Alarm 1 matches the date a month early;
+	// the scheduler notices and waits for the right month.
+	late = 0;
+	setChip(DateTime(2024, 1, 31, 0, 0, 0));
+	uint8_t far = scheduler.add(DateTime(2024, 3, 3, 0, 0, 5).unixtime(), record);
+	expectedDue[far] = DateTime(2024, 3, 3, 0, 0, 5).unixtime();
+	fired[far] = 0;
+	scheduler.service();
+	tick(DateTime(2024, 2, 3, 0, 0, 5).unixtime() - simNow);
+	CHECK(chip.regs[0x0F] & 0x01);
+	CHECK_EQ(scheduler.service(), 0);
+	CHECK_EQ(chip.regs[0x0F] & 0x01, 0);	// flag cleared
+	tick(DateTime(2024, 3, 3, 0, 0, 5).unixtime() - simNow);
+	CHECK_EQ(scheduler.service(), 1);
+	CHECK_EQ(fired[far], 1);
+	CHECK_EQ(late, 0);
+
+	// Missed periods are skipped, not replayed.
+	late = 0;
+	uint8_t hourly = scheduler.add(simNow + 3600, record, 3600);
+	fired[hourly] = 0;
+	scheduler.service();
+	tick(5 * 3600 + 10);
+	CHECK_EQ(scheduler.service(), 1);
+	CHECK_EQ(fired[hourly], 1);
+	CHECK_EQ(scheduler.next(), simNow - 10 + 3600);
+
+	// A bus error while programming Alarm 1 is retried at the next
+	// service(), for the read of setAlarm() and for its write.
+	late = 0;
+	uint8_t retried = scheduler.add(simNow + 20, record);
+	expectedDue[retried] = simNow + 20;
+	fired[retried] = 0;
+	byte second = DS3231BCD::encode(DateTime(simNow + 20).second());
+	Wire.failNext(1, 4);		// after the status and time reads
+	scheduler.service();
+	CHECK(chip.regs[0x07] != second);
+	Wire.failNext(1, 6);
+	scheduler.service();
+	CHECK(chip.regs[0x07] != second);
+	scheduler.service();
+	CHECK_EQ(chip.regs[0x07], second);
+	CHECK_EQ(chip.regs[0x0E] & 0b101, 0b101);
+	tick(20);
+	CHECK_EQ(scheduler.service(), 1);
+	CHECK_EQ(fired[retried], 1);
+	CHECK_EQ(late, 0);
+
+	// Full storage
+	while (scheduler.size() < 8) scheduler.add(simNow + 100000UL, record);
+	CHECK_EQ(scheduler.add(simNow + 1, record), 0);
+
+	return checkReport("scheduler_test");
+}
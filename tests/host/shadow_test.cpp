@@ -0,0 +1,113 @@
+/*
+ * shadow_test.cpp
+ *
+ * The register shadow must serve a full timestamp from one burst read,
+ * stay coherent across writes and refresh once it goes stale.
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static void readAllFields(DS3231& rtc, byte* out) {
+	bool h12, pm, century;
+	out[0] = rtc.getSecond();
+	out[1] = rtc.getMinute();
+	out[2] = rtc.getHour(h12, pm);
+	out[3] = rtc.getDate();
+	out[4] = rtc.getMonth(century);
+	out[5] = rtc.getYear();
+}
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	byte fields[6];
+
+	chip.setTime(23, 12, 31, 7, 23, 59, 58);
+
+	// Without the shadow every getter is its own write + read.
+	Wire.resetCounters();
+	readAllFields(rtc, fields);
+	CHECK_EQ(Wire.counters.transactions, 12);
+
+	// With the shadow the six getters cost one write + one read.
+	rtc.setShadowMaxAge(500);
+	Wire.resetCounters();
+	readAllFields(rtc, fields);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(fields[0], 58);
+	CHECK_EQ(fields[2], 23);
+	CHECK_EQ(fields[5], 23);
+
+	// Alarm, enable and oscillator queries come from the same copy.
+	byte day, hour, minute, second, bits = 0;
+	bool dy, h12, pm;
+	rtc.getA1Time(day, hour, minute, second, bits, dy, h12, pm);
+	rtc.getA2Time(day, hour, minute, bits, dy, h12, pm);
+	rtc.checkAlarmEnabled(1);
+	rtc.oscillatorCheck();
+	CHECK_EQ(Wire.counters.transactions, 2);
+
+	// Writes go through to the device and to the shadow.
+	rtc.setMinute(7);
+	CHECK_EQ(Wire.counters.transactions, 3);
+	CHECK_EQ(rtc.getMinute(), 7);
+	CHECK_EQ(chip.regs[0x01], 0x07);
+	CHECK_EQ(Wire.counters.transactions, 3);
+
+	// Once the window has passed the next read refreshes.
+	chip.advanceSeconds(2);
+	CHECK_EQ(rtc.getSecond(), 58);
+	delay(501);
+	CHECK_EQ(rtc.getSecond(), 0);
+	CHECK_EQ(Wire.counters.transactions, 5);
+
+	// An explicit invalidate forces a refresh as well.
+	chip.advanceSeconds(1);
+	rtc.invalidateShadow();
+	CHECK_EQ(rtc.getSecond(), 1);
+	CHECK_EQ(Wire.counters.transactions, 7);
+
+	// The hour written back by setClockMode() is the device's, not the
+	// shadow's.
+	chip.setTime(23, 12, 31, 7, 9, 59, 59);
+	rtc.invalidateShadow();
+	rtc.getSecond();
+	chip.advanceSeconds(1);
+	rtc.setClockMode(false);
+	CHECK_EQ(chip.regs[0x02], 0x10);
+	rtc.invalidateShadow();
+
+	// A failed write leaves the shadow with what the device holds.
+	byte minuteReg = chip.regs[0x01];
+	Wire.failNext(1);
+	rtc.setMinute(30);
+	CHECK_EQ(chip.regs[0x01], minuteReg);
+	CHECK_EQ(rtc.getMinute(), DS3231BCD::decode(minuteReg));
+
+	// Alarm flags are never served from the shadow.
+	chip.regs[0x0F] |= 0x01;
+	CHECK(rtc.checkIfAlarm(1));
+	CHECK_EQ(chip.regs[0x0F] & 0x01, 0);
+	DS3231AlarmConfig alarm1, alarm2;
+	CHECK(rtc.getAlarms(alarm1, alarm2));
+	CHECK(!alarm2.flag);
+	chip.regs[0x0F] |= 0x02;
+	Wire.resetCounters();
+	CHECK(rtc.getAlarms(alarm1, alarm2));
+	CHECK(alarm2.flag);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	chip.regs[0x0F] &= ~0x02;
+	CHECK(rtc.getAlarm(2, alarm2));
+	CHECK(!alarm2.flag);
+
+	// Disabling the shadow goes back to one read per getter.
+	rtc.setShadowMaxAge(0);
+	Wire.resetCounters();
+	readAllFields(rtc, fields);
+	CHECK_EQ(Wire.counters.transactions, 12);
+
+	return checkReport("shadow_test");
+}
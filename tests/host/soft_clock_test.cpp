@@ -0,0 +1,86 @@
+/*
+ * soft_clock_test.cpp
+ *
+ * Drives DS3231SoftClock with simulated SQW edges from an MCU whose
+ * micros() runs 250 ppm fast, and checks the interpolated time, the
+ * drift estimate, recovery from a missed edge and the absence of bus
+ * traffic between anchors.
+ */
+
+#include <DS3231SoftClock.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static MockDS3231 chip;
+static const unsigned long mcuSecond = 1000250UL;	// 250 ppm fast
+static unsigned long edgeAt = 5000000UL;
+
+// One RTC second: the chip ticks and the SQW edge fires.
+static void rtcSecond(DS3231SoftClock& clock, bool deliverEdge = true) {
+	edgeAt += mcuSecond;
+	mockSetMicros(edgeAt);
+	chip.advanceSeconds(1);
+	if (deliverEdge) clock.onEdge();
+}
+
+int main() {
+	Wire.attach(&chip);
+	DS3231 rtc;
+	DS3231SoftClock clock(rtc);
+	uint32_t seconds, us;
+
+	chip.setTime(24, 3, 10, 7, 12, 0, 0);	// 2024-03-10 12:00:00
+	const uint32_t base = 1710072000UL;
+	clock.begin();
+	CHECK_EQ(chip.regs[0x0E] & 0b00011100, 0);	// 1 Hz, INTCN off
+	CHECK(!clock.now(seconds, us));
+
+	// First edge, then anchor from loop().
+	rtcSecond(clock);
+	mockAdvanceMicros(1000);
+	CHECK(clock.update());
+	CHECK_EQ(clock.unixtime(), base + 1);
+
+	// Ten seconds later the rate gets measured.
+	for (int i = 0; i < 10; i++) rtcSecond(clock);
+	mockAdvanceMicros(1000);
+	CHECK(clock.update());
+	CHECK_EQ(clock.getDrift(), 250);
+
+	// Half an RTC second after an edge, with no bus traffic.
+	rtcSecond(clock);
+	Wire.resetCounters();
+	mockSetMicros(edgeAt + mcuSecond / 2);
+	CHECK(clock.update());
+	for (int i = 0; i < 1000; i++) clock.now(seconds, us);
+	CHECK_EQ(Wire.counters.transactions, 0);
+	CHECK_EQ(seconds, base + 12);
+	CHECK(us >= 499998 && us <= 500002);
+
+	// Just before the next edge the fraction never reaches a full second.
+	mockSetMicros(edgeAt + mcuSecond - 1);
+	clock.now(seconds, us);
+	CHECK_EQ(seconds, base + 12);
+	CHECK(us >= 999990 && us <= 999999);
+
+	// A missed edge is noticed at the next one and re-anchored.
+	rtcSecond(clock, false);
+	rtcSecond(clock);
+	mockAdvanceMicros(1000);
+	CHECK(clock.update());
+	CHECK_EQ(clock.unixtime(), base + 14);
+	CHECK_EQ(clock.getDrift(), 250);
+
+	// Periodic resync: one RTC read per interval.
+	clock.setResyncInterval(60);
+	Wire.resetCounters();
+	for (int i = 0; i < 120; i++) {
+		rtcSecond(clock);
+		mockAdvanceMicros(1000);
+		clock.update();
+	}
+	CHECK_EQ(Wire.counters.reads, 2);
+	CHECK_EQ(clock.unixtime(), base + 134);
+
+	return checkReport("soft_clock_test");
+}
@@ -0,0 +1,88 @@
+/*
+ * temperature_test.cpp
+ *
+ * Integer temperature readings, built without the float functions, and
+ * forced conversions.
+ *
+ * host-test-flags: -DDS3231_NO_FLOAT
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	int16_t quarters = 0;
+
+	chip.regs[0x11] = 0x19;	// 25.25 C
+	chip.regs[0x12] = 0x40;
+	CHECK(rtc.getTemperatureQuarters(quarters));
+	CHECK_EQ(quarters, 101);
+
+	chip.regs[0x11] = 0xE6;	// -25.75 C
+	chip.regs[0x12] = 0x40;
+	CHECK(rtc.getTemperatureQuarters(quarters));
+	CHECK_EQ(quarters, -103);
+
+	chip.regs[0x11] = 0xFF;	// -0.25 C; unused low bits are ignored
+	chip.regs[0x12] = 0xFF;
+	CHECK(rtc.getTemperatureQuarters(quarters));
+	CHECK_EQ(quarters, -1);
+
+	chip.regs[0x11] = 0x7F;	// top of the range
+	chip.regs[0x12] = 0xC0;
+	CHECK(rtc.getTemperatureQuarters(quarters));
+	CHECK_EQ(quarters, 511);
+	CHECK_EQ(quarters << 6, 0x7FC0);	// Q8.8
+
+	// One two-byte read, nothing else.
+	Wire.resetCounters();
+	rtc.getTemperatureQuarters(quarters);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK_EQ(Wire.counters.bytesRead, 2);
+
+	// A bus error is reported and leaves the value alone.
+	quarters = 1234;
+	Wire.failNext(1);
+	CHECK(!rtc.getTemperatureQuarters(quarters));
+	CHECK_EQ(quarters, 1234);
+
+	// Forced conversion: CONV is polled, never waited on.
+	chip.setTemperatureQuarters(-3);
+	CHECK(rtc.startTemperatureConversion());
+	CHECK_EQ(chip.conversionsStarted, 1);
+	CHECK(chip.regs[0x0E] & 0b00100000);
+	CHECK_EQ(chip.regs[0x0E] & 0b00011111, 0b00011100);	// rest untouched
+	CHECK(!rtc.startTemperatureConversion());	// no overlap
+	CHECK_EQ(chip.conversionsStarted, 1);
+	quarters = 1234;
+	CHECK_EQ(rtc.pollTemperatureConversion(quarters), DS3231::ConversionBusy);
+	CHECK_EQ(quarters, 1234);
+	int polls = 1;
+	while (rtc.pollTemperatureConversion(quarters) == DS3231::ConversionBusy) {
+		mockAdvanceMicros(10000);
+		polls++;
+	}
+	CHECK_EQ(quarters, -3);
+	CHECK(polls > 5 && polls < 20);	// about 125 ms in 10 ms steps
+	CHECK_EQ(chip.regs[0x0E] & 0b00100000, 0);
+
+	// An automatic conversion in progress (BSY) also blocks a start.
+	chip.regs[0x0F] |= 0b00000100;
+	CHECK(!rtc.startTemperatureConversion());
+	CHECK_EQ(chip.conversionsStarted, 1);
+	chip.regs[0x0F] &= ~0b00000100;
+	CHECK(rtc.startTemperatureConversion());
+	CHECK_EQ(chip.conversionsStarted, 2);
+
+	// Errors are reported, not mistaken for busy or done.
+	Wire.failNext(1);
+	CHECK_EQ(rtc.pollTemperatureConversion(quarters), DS3231::ConversionFailed);
+	Wire.failNext(1);
+	CHECK(!rtc.startTemperatureConversion());
+
+	return checkReport("temperature_test");
+}
@@ -0,0 +1,110 @@
+/*
+ * time_parser_test.cpp
+ *
+ * DS3231TimeParser, fed one character at a time, and the burst write of
+ * its result.
+ */
+
+#include <DS3231.h>
+#include <DS3231TimeParser.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+// Feeds a whole string; returns the last result other than Incomplete,
+// or Incomplete if there was none.
+static DS3231TimeParser::Result feedAll(DS3231TimeParser& parser, const char* s) {
+	DS3231TimeParser::Result last = DS3231TimeParser::Incomplete;
+	while (*s) {
+		DS3231TimeParser::Result r = parser.feed(*s++);
+		if (r != DS3231TimeParser::Incomplete) last = r;
+	}
+	return last;
+}
+
+static bool rejects(const char* s) {
+	DS3231TimeParser parser;
+	return feedAll(parser, s) == DS3231TimeParser::Invalid;
+}
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	DS3231TimeParser parser;
+
+	CHECK(!parser.apply(rtc));	// nothing read yet
+
+	// Compact format, as the DS3231_set example reads it
+	CHECK_EQ(feedAll(parser, "2406156123045"), DS3231TimeParser::Incomplete);
+	CHECK_EQ(parser.feed('x'), DS3231TimeParser::Complete);
+	CHECK_EQ(parser.getYear(), 24);
+	CHECK_EQ(parser.getMonth(), 6);
+	CHECK_EQ(parser.getDate(), 15);
+	CHECK_EQ(parser.getDoW(), 6);
+	CHECK_EQ(parser.getHour(), 12);
+	CHECK_EQ(parser.getMinute(), 30);
+	CHECK_EQ(parser.getSecond(), 45);
+
+	// ISO 8601, with the weekday worked out (2024-02-29 was a Thursday)
+	CHECK_EQ(feedAll(parser, "\r\n2024-02-29T23:59:58Z"), DS3231TimeParser::Complete);
+	CHECK_EQ(parser.getYear(), 24);
+	CHECK_EQ(parser.getMonth(), 2);
+	CHECK_EQ(parser.getDate(), 29);
+	CHECK_EQ(parser.getDoW(), 4);
+	CHECK_EQ(parser.getHour(), 23);
+	CHECK_EQ(parser.getSecond(), 58);
+	CHECK_EQ(parser.getDateTime().unixtime(), 1709251198UL);
+	CHECK_EQ(feedAll(parser, "2030-01-06 07:08:09.123\n"), DS3231TimeParser::Complete);
+	CHECK_EQ(parser.getDoW(), 7);	// a Sunday
+	CHECK_EQ(parser.getMinute(), 8);
+
+	// Out of range, malformed, or in an unsupported form
+	CHECK(rejects("2023-02-29T00:00:00Z"));
+	CHECK(rejects("2024-13-01T00:00:00Z"));
+	CHECK(rejects("2024-04-31T00:00:00Z"));
+	CHECK(rejects("2024-04-30T24:00:00Z"));
+	CHECK(rejects("2024-04-30T23:60:00Z"));
+	CHECK(rejects("1999-12-31T23:59:59Z"));
+	CHECK(rejects("2024-04-30T12:00:00+02:00"));
+	CHECK(rejects("2024-4-30T12:00:00Z"));
+	CHECK(rejects("2406158123045x"));	// day of week 8
+	CHECK(rejects("240615612304x"));	// one digit short
+	CHECK(rejects("24061561230456x"));	// one digit too many
+	CHECK(rejects("hello\n"));
+
+	// A bad line is skipped, and the next one is read normally.
+	parser.reset();
+	CHECK_EQ(feedAll(parser, "2024-99-01T00:00:00 garbage\n"), DS3231TimeParser::Invalid);
+	CHECK_EQ(feedAll(parser, "2025-01-01T00:00:00\n"), DS3231TimeParser::Complete);
+	CHECK_EQ(parser.getYear(), 25);
+
+	// ... also when it ends early, in either format
+	CHECK_EQ(feedAll(parser, "2024-06\n2024-06-15T12:30:00\n"), DS3231TimeParser::Complete);
+	CHECK_EQ(parser.getDate(), 15);
+	CHECK_EQ(parser.getMinute(), 30);
+	CHECK_EQ(feedAll(parser, "24061561230\n2406156123000x"), DS3231TimeParser::Complete);
+	CHECK_EQ(parser.getHour(), 12);
+	CHECK_EQ(parser.getMinute(), 30);
+	CHECK_EQ(parser.getSecond(), 0);
+	CHECK_EQ(parser.feed('2'), DS3231TimeParser::Incomplete);
+	CHECK_EQ(parser.feed('\r'), DS3231TimeParser::Invalid);
+
+	// The result goes to the DS3231 in one burst, with the OSF cleared.
+	CHECK_EQ(feedAll(parser, "2406156123045x"), DS3231TimeParser::Complete);
+	Wire.resetCounters();
+	CHECK(parser.apply(rtc));
+	CHECK_EQ(Wire.counters.writes, 3);	// read pointer, time burst, status
+	CHECK_EQ(chip.regs[0x00], 0x45);
+	CHECK_EQ(chip.regs[0x01], 0x30);
+	CHECK_EQ(chip.regs[0x02], 0x12);
+	CHECK_EQ(chip.regs[0x03], 6);
+	CHECK_EQ(chip.regs[0x04], 0x15);
+	CHECK_EQ(chip.regs[0x05], 0x06);
+	CHECK_EQ(chip.regs[0x06], 0x24);
+	CHECK_EQ(chip.regs[0x0F] & 0x80, 0);
+
+	Wire.failNext(1);
+	CHECK(!parser.apply(rtc));
+
+	return checkReport("time_parser_test");
+}
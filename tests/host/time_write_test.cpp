@@ -0,0 +1,106 @@
+/*
+ * time_write_test.cpp
+ *
+ * setEpoch(), adjust() and setDateTime() must each put the time
+ * registers on the bus in a single burst, and partial updates must only
+ * touch the registers they were asked to change.
+ */
+
+#include <DS3231.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+int main() {
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+
+	// 2023-07-14 09:26:53 UTC, a Friday
+	const uint32_t epoch = 1689326813UL;
+
+	// setEpoch: one read (0x00-0x0f), one time write, one status write.
+	chip.regs[0x0F] = 0b10001011;	// OSF, EN32kHz, A2F, A1F
+	Wire.resetCounters();
+	rtc.setEpoch(epoch);
+	CHECK_EQ(Wire.counters.transactions, 4);
+	CHECK_EQ(Wire.counters.writes, 3);
+	CHECK_EQ(chip.regs[0x00], 0x53);
+	CHECK_EQ(chip.regs[0x01], 0x26);
+	CHECK_EQ(chip.regs[0x02], 0x09);
+	CHECK_EQ(chip.regs[0x03], 6);	// tm_wday + 1, Sunday == 1
+	CHECK_EQ(chip.regs[0x04], 0x14);
+	CHECK_EQ(chip.regs[0x05], 0x07);
+	CHECK_EQ(chip.regs[0x06], 0x23);
+	CHECK_EQ(chip.regs[0x0F], 0b00001011);	// OSF cleared, flags kept
+
+	// A failed status write is reported, and the OSF stays set.
+	chip.regs[0x0F] = 0b10001000;
+	Wire.failNext(1, 3);
+	CHECK(!rtc.setDateTime(23, 7, 14, 6, 9, 26, 53));
+	CHECK_EQ(rtc.getLastError(), DS3231::BusError);
+	CHECK_EQ(chip.regs[0x0F], 0b10001000);
+	CHECK_EQ(chip.regs[0x00], 0x53);
+
+	// The 12h mode survives setEpoch, as it did with setHour().
+	rtc.setClockMode(true);
+	rtc.setEpoch(epoch + 6UL * 3600UL);
+	CHECK_EQ(chip.regs[0x02], 0b01100011);	// 3 PM
+
+	// adjust(): a single 7-byte write, alarm 1 left alone.
+	chip.regs[0x07] = 0x45;
+	Wire.resetCounters();
+	rtc.adjust(DateTime(2024, 2, 29, 23, 59, 30));
+	CHECK_EQ(Wire.counters.transactions, 1);
+	CHECK_EQ(Wire.counters.bytesWritten, 8);
+	CHECK_EQ(chip.regs[0x07], 0x45);
+	CHECK_EQ(chip.regs[0x02], 0x23);
+	CHECK_EQ(chip.regs[0x04], 0x29);
+
+	// A partial update reads once and writes only the hour register.
+	rtc.setClockMode(true);
+	Wire.resetCounters();
+	rtc.setDateTime(0, 0, 0, 0, 0, 0, 0, DS3231::HourField);
+	CHECK_EQ(Wire.counters.transactions, 3);
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 2);	// read pointer, then 0x02
+	CHECK_EQ(chip.regs[0x02], 0b01010010);	// 12 AM
+	CHECK_EQ(chip.regs[0x00], 0x30);
+
+	// Date and year are written as one span.
+	Wire.resetCounters();
+	rtc.setDateTime(25, 0, 1, 0, 0, 0, 0, DS3231::DateField | DS3231::YearField);
+	CHECK_EQ(Wire.counters.bytesWritten, 1 + 4);	// read pointer, then 0x04-0x06
+	CHECK_EQ(chip.regs[0x04], 0x01);
+	CHECK_EQ(chip.regs[0x05], 0x02);
+	CHECK_EQ(chip.regs[0x06], 0x25);
+
+	// With a fresh shadow the full write needs no read at all.
+	rtc.setShadowMaxAge(1000);
+	rtc.refreshShadow();
+	Wire.resetCounters();
+	rtc.setEpoch(epoch);
+	CHECK_EQ(Wire.counters.reads, 0);
+	CHECK_EQ(Wire.counters.transactions, 2);
+	CHECK(rtc.oscillatorCheck());
+
+	// A span with unselected registers reads them from the device, not
+	// from a shadow that has fallen behind the running clock.
+	rtc.setClockMode(false);
+	rtc.adjust(DateTime(2024, 3, 1, 10, 59, 58));
+	rtc.refreshShadow();
+	chip.advanceSeconds(3);		// 11:00:01
+	Wire.resetCounters();
+	rtc.setDateTime(0, 0, 0, 0, 11, 0, 30, DS3231::SecondField | DS3231::HourField);
+	CHECK_EQ(Wire.counters.reads, 1);
+	CHECK_EQ(chip.regs[0x00], 0x30);
+	CHECK_EQ(chip.regs[0x01], 0x00);
+	CHECK_EQ(chip.regs[0x02], 0x11);
+
+	// A contiguous span is still served from the shadow.
+	Wire.resetCounters();
+	rtc.setDateTime(0, 0, 0, 0, 12, 15, 0, DS3231::MinuteField | DS3231::HourField);
+	CHECK_EQ(Wire.counters.reads, 0);
+	CHECK_EQ(chip.regs[0x01], 0x15);
+	CHECK_EQ(chip.regs[0x02], 0x12);
+
+	return checkReport("time_write_test");
+}
@@ -0,0 +1,112 @@
+/*
+ * time_zone_test.cpp
+ *
+ * DS3231TimeZone against the C library's own reading of the equivalent
+ * POSIX TZ strings, for random times and every transition of 2000-2099,
+ * in both hemispheres and without DST.
+ */
+
+#include <time.h>
+#include <DS3231TimeZone.h>
+#include "MockDS3231.h"
+#include "check.h"
+
+static uint32_t seed = 5;
+
+static uint32_t nextRandom() {
+	seed = seed * 1103515245UL + 12345UL;
+	return seed >> 4;
+}
+
+// Offset in minutes from the C library, with TZ already set
+static int16_t referenceOffset(uint32_t utc) {
+	time_t t = utc;
+	struct tm local;
+	localtime_r(&t, &local);
+	return (int16_t)(local.tm_gmtoff / 60);
+}
+
+static void checkZone(const char* tz, DS3231TimeZone& zone, int16_t offset, int16_t shift) {
+	setenv("TZ", tz, 1);
+	tzset();
+	const uint32_t first = 946684800UL;		// 2000-01-01
+	const uint32_t last = 4102444799UL;		// 2099-12-31 23:59:59
+	for (uint32_t i = 0; i < 100000UL; i++) {
+		uint32_t utc = first + nextRandom() % (last - first);
+		CHECK_EQ(zone.getOffset(utc), referenceOffset(utc));
+	}
+	for (uint16_t year = 2000; year < 2100; year++) {
+		for (uint8_t start = 0; start < 2; start++) {
+			uint32_t t = zone.getTransition(year, start);
+			if (shift == 0) {
+				CHECK_EQ(t, 0);
+				continue;
+			}
+			CHECK_EQ(zone.getOffset(t - 1), start ? offset : offset + shift);
+			CHECK_EQ(zone.getOffset(t), start ? offset + shift : offset);
+			CHECK_EQ(referenceOffset(t - 1), zone.getOffset(t - 1));
+			CHECK_EQ(referenceOffset(t), zone.getOffset(t));
+			CHECK_EQ(zone.isDst(t), (bool)start);
+		}
+	}
+
+	// Back from local time: exact outside the hour repeated at the end of
+	// DST, the first occurrence inside it
+	for (uint32_t i = 0; i < 20000UL; i++) {
+		uint32_t utc = first + 86400UL + nextRandom() % (last - first - 2 * 86400UL);
+		uint32_t local = zone.toLocal(utc);
+		uint32_t back = zone.toUtc(local);
+		if (back != utc) {
+			CHECK_EQ(back, utc - shift * 60L);
+			CHECK_EQ(zone.toLocal(back), local);
+		}
+		CHECK_EQ(zone.toLocal(DateTime(utc)).unixtime(), local);
+		CHECK_EQ(zone.toUtc(DateTime(local)).unixtime(), back);
+	}
+}
+
+int main() {
+	// Central Europe: last Sunday of March 02:00 to last Sunday of
+	// October 03:00
+	DS3231DstRule euStart = { 3, 5, 0, 120 };
+	DS3231DstRule euEnd = { 10, 5, 0, 180 };
+	DS3231TimeZone berlin(60, 60, euStart, euEnd);
+	checkZone("CET-1CEST,M3.5.0,M10.5.0/3", berlin, 60, 60);
+
+	// US Eastern: second Sunday of March to first Sunday of November
+	DS3231DstRule usStart = { 3, 2, 0, 120 };
+	DS3231DstRule usEnd = { 11, 1, 0, 120 };
+	DS3231TimeZone newYork(-300, 60, usStart, usEnd);
+	checkZone("EST5EDT,M3.2.0,M11.1.0", newYork, -300, 60);
+
+	// Southern hemisphere: DST across the new year
+	DS3231DstRule auStart = { 10, 1, 0, 120 };
+	DS3231DstRule auEnd = { 4, 1, 0, 180 };
+	DS3231TimeZone sydney(600, 60, auStart, auEnd);
+	checkZone("AEST-10AEDT,M10.1.0,M4.1.0/3", sydney, 600, 60);
+
+	// Half-hour offset, no DST
+	DS3231TimeZone india(330);
+	checkZone("IST-5:30", india, 330, 0);
+	CHECK(!india.isDst(1700000000UL));
+
+	// The gap at the start of DST is read as standard time
+	uint32_t start2024 = berlin.getTransition(2024, true);
+	CHECK_EQ(start2024, 1711846800UL);			// 2024-03-31 01:00 UTC
+	CHECK_EQ(berlin.toUtc(DateTime(2024, 3, 31, 2, 30, 0)).unixtime(), start2024 + 1800);
+
+	// setEpoch() writes the local time
+	MockDS3231 chip;
+	Wire.attach(&chip);
+	DS3231 rtc;
+	rtc.setEpoch(1720000000UL, berlin);			// 2024-07-03 09:46:40 UTC
+	DateTime dt;
+	CHECK(rtc.now(dt));
+	CHECK_EQ(dt.hour(), 11);
+	CHECK_EQ(dt.minute(), 46);
+	rtc.setEpoch(1720000000UL, newYork);
+	CHECK(rtc.now(dt));
+	CHECK_EQ(dt.hour(), 5);
+
+	return checkReport("time_zone_test");
+}